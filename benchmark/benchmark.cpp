@@ -0,0 +1,92 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <QByteArray>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+
+#include "torrentcreator.h"
+
+namespace lt = libtorrent;
+
+volatile std::uintptr_t benchmarkSink;
+
+
+double nanosSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+std::vector<lt::sha1_hash> randomHashes(std::size_t count, std::mt19937 &random)
+{
+	std::vector<lt::sha1_hash> hashes(count);
+	for (lt::sha1_hash &hash : hashes) {
+		for (auto it = hash.begin(); it != hash.end(); ++it) {
+			*it = static_cast<unsigned char>(random());
+		}
+	}
+	return hashes;
+}
+
+//! Writes a directory of files with random content named 0, 1, ...
+bool makeTree(const QString &dirName, int files, qint64 fileSize, std::mt19937 &random)
+{
+	if (!QDir().mkpath(dirName))
+		return false;
+	for (int i = 0; i < files; ++i) {
+		if (!fillFile(QDir(dirName).filePath(QString::number(i)), fileSize, random))
+			return false;
+	}
+	return true;
+}
+
+//! Writes a file with random content.
+bool fillFile(const QString &fileName, qint64 size, std::mt19937 &random)
+{
+	QFile file(fileName);
+	if (!file.open(QFile::WriteOnly))
+		return false;
+	std::vector<std::uint32_t> buffer(64 * 1024);
+	const qint64 bufferSize = buffer.size() * sizeof(std::uint32_t);
+	for (qint64 written = 0; written < size; written += bufferSize) {
+		for (std::uint32_t &word : buffer) {
+			word = random();
+		}
+		const qint64 length = std::min(bufferSize, size - written);
+		if (file.write(reinterpret_cast<const char*>(buffer.data()), length) != length)
+			return false;
+	}
+	return true;
+}
+
+//! Creates a torrent and returns the time it took in ms, or -1 if it failed.
+double createTorrent(TorrentCreator &creator, const QString &fileOrDirName,
+                     QByteArray *torrent)
+{
+	QEventLoop loop;
+	bool succeeded = false;
+	QObject::connect(&creator, &TorrentCreator::finished, &loop, [&](const QByteArray &data) {
+		succeeded = true;
+		if (torrent)
+			*torrent = data;
+		loop.quit();
+	});
+	QObject::connect(&creator, &TorrentCreator::failed, &loop, &QEventLoop::quit);
+	const Clock::time_point start = Clock::now();
+	creator.start(fileOrDirName);
+	loop.exec();
+	return succeeded ? nanosSince(start) / 1e6 : -1;
+}
+
+//! Prints the time and the throughput of a transfer, if it did not fail.
+void printThroughput(const char *name, double ms, double bytes)
+{
+	if (ms < 0)
+		std::printf("%-32s failed\n", name);
+	else
+		std::printf("%-32s %10.1f ms %10.1f MiB/s\n", name, ms,
+		            bytes / 1024 / 1024 / (ms / 1000));
+}
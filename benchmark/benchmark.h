@@ -0,0 +1,45 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <QString>
+
+#include <libtorrent/peer_id.hpp>
+
+QT_BEGIN_NAMESPACE
+class QByteArray;
+QT_END_NAMESPACE
+class TorrentCreator;
+
+typedef std::chrono::steady_clock Clock;
+
+// Numbers of torrents or rows the containers are compared at.
+static const int BENCHMARK_SIZES[] = {100, 10000, 100000};
+// Files of the trees torrents are created from.
+static const int TREE_FILES = 100;
+
+// The benchmarks print their results to the standard output.
+void benchmarkTorrentIndex();
+void benchmarkIndexedList();
+void benchmarkTorrentCreator(int treeSize);
+void benchmarkPieceHashCache();
+void benchmarkTorrentLoader();
+void benchmarkSessionProfiles(int treeSize);
+
+double nanosSince(Clock::time_point start);
+std::vector<libtorrent::sha1_hash> randomHashes(std::size_t count, std::mt19937 &random);
+bool makeTree(const QString &dirName, int files, qint64 fileSize, std::mt19937 &random);
+bool fillFile(const QString &fileName, qint64 size, std::mt19937 &random);
+double createTorrent(TorrentCreator &creator, const QString &fileOrDirName,
+                     QByteArray *torrent = nullptr);
+void printThroughput(const char *name, double ms, double bytes);
+
+//! Results are summed up into this, so the timed loops are not optimized away.
+extern volatile std::uintptr_t benchmarkSink;
+
+#endif // BENCHMARK_H
@@ -0,0 +1,35 @@
+#-------------------------------------------------
+#
+# Micro-benchmarks of the model. They do not need a GUI, so they run on build
+# machines as well. Build with qmake benchmark.pro and run lan-client-benchmark
+# with the names of the benchmarks to run, or without arguments to run all.
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+CONFIG   += C++11 console
+CONFIG   -= app_bundle
+
+TARGET = lan-client-benchmark
+TEMPLATE = app
+
+exists(../custom.pri):include(../custom.pri)
+
+LIBS += -ltorrent -lboost_system
+win32-g++:LIBS += -lWs2_32 -lMswsock
+
+
+include(../common/common.pri)
+include(../model/model.pri)
+
+SOURCES += $$PWD/main.cpp \
+    $$PWD/benchmark.cpp \
+    $$PWD/indexedlistbenchmark.cpp \
+    $$PWD/piecehashcachebenchmark.cpp \
+    $$PWD/sessionprofilebenchmark.cpp \
+    $$PWD/torrentcreatorbenchmark.cpp \
+    $$PWD/torrentindexbenchmark.cpp \
+    $$PWD/torrentloaderbenchmark.cpp
+
+HEADERS  += $$PWD/benchmark.h
@@ -0,0 +1,82 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+#include "indexedlist.h"
+
+// Operations timed per size. The vector takes linear time for most of them.
+static const int OPERATIONS = 10000;
+
+
+/**
+ * @brief Compares IndexedList against a vector with linear searches.
+ *
+ * The torrent models look up the row of a torrent on every status update and
+ * move rows when torrents are added, removed or sorted.
+ */
+void benchmarkIndexedList()
+{
+	std::printf("IndexedList against std::vector in ns per operation\n");
+	std::printf("%9s %12s %12s %12s %12s %12s %12s\n", "rows",
+	            "vector row", "list row", "vector at", "list at",
+	            "vector move", "list move");
+
+	std::mt19937 random(2);
+	for (const int size : BENCHMARK_SIZES) {
+		std::vector<int> values(size);
+		std::iota(values.begin(), values.end(), 0);
+		std::shuffle(values.begin(), values.end(), random);
+		IndexedList<int> list;
+		list.assign(values);
+
+		std::vector<int> lookups(OPERATIONS);
+		std::vector<int> rows(OPERATIONS);
+		for (int i = 0; i < OPERATIONS; ++i) {
+			lookups[i] = random() % size;
+			rows[i] = random() % size;
+		}
+
+		std::uintptr_t sum = 0;
+		Clock::time_point start = Clock::now();
+		for (const int value : lookups) {
+			sum += std::find(values.begin(), values.end(), value) - values.begin();
+		}
+		const double vectorRow = nanosSince(start) / OPERATIONS;
+		start = Clock::now();
+		for (const int value : lookups) {
+			sum += list.indexOf(value);
+		}
+		const double listRow = nanosSince(start) / OPERATIONS;
+
+		start = Clock::now();
+		for (const int row : rows) {
+			sum += values[row];
+		}
+		const double vectorAt = nanosSince(start) / OPERATIONS;
+		start = Clock::now();
+		for (const int row : rows) {
+			sum += list.at(row);
+		}
+		const double listAt = nanosSince(start) / OPERATIONS;
+		benchmarkSink = sum;
+
+		// Move a value to another row, like a torrent whose sort key changed.
+		start = Clock::now();
+		for (int i = 0; i < OPERATIONS; ++i) {
+			values.erase(std::find(values.begin(), values.end(), lookups[i]));
+			values.insert(values.begin() + std::min<int>(rows[i], values.size()), lookups[i]);
+		}
+		const double vectorMove = nanosSince(start) / OPERATIONS;
+		start = Clock::now();
+		for (int i = 0; i < OPERATIONS; ++i) {
+			list.remove(lookups[i]);
+			list.insert(std::min(rows[i], list.size()), lookups[i]);
+		}
+		const double listMove = nanosSince(start) / OPERATIONS;
+
+		std::printf("%9d %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n", size,
+		            vectorRow, listRow, vectorAt, listAt, vectorMove, listMove);
+	}
+}
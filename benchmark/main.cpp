@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <cstdio>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QStringList>
+
+#include "benchmark.h"
+
+// Default size of the trees torrents are created from in MiB.
+static const int DEFAULT_TREE_SIZE = 256;
+
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("lan-client-benchmark"));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("Micro-benchmarks of the lan-client model."));
+	parser.addHelpOption();
+	const QCommandLineOption treeSizeOption(QStringLiteral("tree-size"),
+			QStringLiteral("Size of the trees torrents are created from in MiB."),
+			QStringLiteral("MiB"), QString::number(DEFAULT_TREE_SIZE));
+	parser.addOption(treeSizeOption);
+	parser.addPositionalArgument(QStringLiteral("benchmarks"),
+	                             QStringLiteral("Any of index, list, cache, creator, loader and swarm. "
+	                                            "All of them run by default."));
+	parser.process(app);
+
+	QStringList benchmarks = parser.positionalArguments();
+	if (benchmarks.isEmpty()) {
+		benchmarks << QStringLiteral("index") << QStringLiteral("list")
+		           << QStringLiteral("cache") << QStringLiteral("creator")
+		           << QStringLiteral("loader") << QStringLiteral("swarm");
+	}
+	const int treeSize = std::max(1, parser.value(treeSizeOption).toInt());
+	for (const QString &name : benchmarks) {
+		if (name == QLatin1String("index")) {
+			benchmarkTorrentIndex();
+		} else if (name == QLatin1String("list")) {
+			benchmarkIndexedList();
+		} else if (name == QLatin1String("cache")) {
+			benchmarkPieceHashCache();
+		} else if (name == QLatin1String("creator")) {
+			benchmarkTorrentCreator(treeSize);
+		} else if (name == QLatin1String("loader")) {
+			benchmarkTorrentLoader();
+		} else if (name == QLatin1String("swarm")) {
+			benchmarkSessionProfiles(treeSize);
+		} else {
+			std::fprintf(stderr, "Unknown benchmark %s\n", qPrintable(name));
+			return 1;
+		}
+		std::printf("\n");
+	}
+	return 0;
+}
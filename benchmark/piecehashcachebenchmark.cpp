@@ -0,0 +1,66 @@
+#include "benchmark.h"
+
+#include <cstdio>
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "piecehashcache.h"
+
+namespace lt = libtorrent;
+
+// Pieces of a 50 GB tree with 256 KiB pieces.
+static const int PIECES = 200000;
+
+
+//! Measures the lookups and the file of a PieceHashCache with the pieces of
+//! a 50 GB tree.
+void benchmarkPieceHashCache()
+{
+	std::printf("PieceHashCache with %d pieces\n", PIECES);
+	QTemporaryDir dir;
+	if (!dir.isValid()) {
+		std::printf("Could not create a temporary directory\n");
+		return;
+	}
+	const QString fileName = QDir(dir.path()).filePath(QStringLiteral("piecehashes"));
+
+	std::mt19937 random(3);
+	const std::vector<lt::sha1_hash> keys = randomHashes(PIECES, random);
+	const std::vector<lt::sha1_hash> missing = randomHashes(PIECES, random);
+	PieceHashCache cache(fileName);
+
+	Clock::time_point start = Clock::now();
+	for (const lt::sha1_hash &key : keys) {
+		cache.insert(key, key);
+	}
+	const double insert = nanosSince(start) / PIECES;
+
+	lt::sha1_hash hash;
+	std::uintptr_t sum = 0;
+	start = Clock::now();
+	for (const lt::sha1_hash &key : keys) {
+		sum += cache.find(key, hash);
+	}
+	const double hit = nanosSince(start) / PIECES;
+	start = Clock::now();
+	for (const lt::sha1_hash &key : missing) {
+		sum += cache.find(key, hash);
+	}
+	const double miss = nanosSince(start) / PIECES;
+	benchmarkSink = sum;
+
+	start = Clock::now();
+	const bool saved = cache.save();
+	const double save = nanosSince(start) / 1e6;
+	PieceHashCache loaded(fileName);
+	start = Clock::now();
+	const bool wasLoaded = loaded.load();
+	const double load = nanosSince(start) / 1e6;
+
+	std::printf("insert %.1f ns, hit %.1f ns, miss %.1f ns per piece\n", insert, hit, miss);
+	std::printf("save %.1f ms%s, load %.1f ms%s, %lld bytes on disk\n",
+	            save, saved ? "" : " (failed)", load, wasLoaded ? "" : " (failed)",
+	            (long long) QFile(fileName).size());
+}
@@ -0,0 +1,121 @@
+#include "benchmark.h"
+
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+#include <QByteArray>
+#include <QDir>
+#include <QTemporaryDir>
+
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/session.hpp>
+#include <libtorrent/session_settings.hpp>
+#include <libtorrent/socket.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+#include "torrentcreator.h"
+#include "torrentsession.h"
+#include "torrentsessionprofile.h"
+
+namespace lt = libtorrent;
+
+static double downloadOverLoopback(TorrentSession::Profile profile, const QByteArray &torrent,
+                                   const QString &seedPath, const QString &leechPath);
+
+// Ports the seeding and the downloading session listen on.
+static const std::pair<int,int> SEED_PORTS(16881, 16891);
+static const std::pair<int,int> LEECH_PORTS(16892, 16902);
+// Time after which a download is given up.
+static const std::chrono::minutes TIMEOUT(5);
+
+
+/**
+ * @brief Measures the throughput of a loopback swarm per session profile.
+ *
+ * A seeding and a downloading session are connected over the loopback
+ * interface. It has neither latency nor packet loss, so this shows the costs
+ * within the sessions, like encryption, buffer sizes and choking, rather than
+ * those of a real network.
+ *
+ * @param treeSize The size of the torrent in MiB.
+ */
+void benchmarkSessionProfiles(int treeSize)
+{
+	std::printf("Loopback swarm with %d MiB in %d files\n", treeSize, TREE_FILES);
+	QTemporaryDir dir;
+	const QString treeName = QDir(dir.path()).filePath(QStringLiteral("tree"));
+	const qint64 fileSize = (qint64) treeSize * 1024 * 1024 / TREE_FILES;
+	std::mt19937 random(6);
+	QByteArray torrent;
+	TorrentCreator creator;
+	if (!dir.isValid() || !makeTree(treeName, TREE_FILES, fileSize, random)
+			|| createTorrent(creator, treeName, &torrent) < 0) {
+		std::printf("Could not create the torrent\n");
+		return;
+	}
+	const double bytes = (double) fileSize * TREE_FILES;
+
+	const std::pair<TorrentSession::Profile, const char*> profiles[] = {
+		{TorrentSession::InternetProfile, "internet profile"},
+		{TorrentSession::LanProfile, "LAN profile"}
+	};
+	for (const auto &profile : profiles) {
+		const QString leechPath = QDir(dir.path()).filePath(
+					QStringLiteral("leech%1").arg(profile.first));
+		printThroughput(profile.second,
+		                downloadOverLoopback(profile.first, torrent, dir.path(), leechPath),
+		                bytes);
+	}
+}
+
+// Downloads the torrent from a seeding session into the leech path. Returns
+// the time it took in ms, or -1 if it failed or timed out.
+static double downloadOverLoopback(TorrentSession::Profile profile, const QByteArray &torrent,
+                                   const QString &seedPath, const QString &leechPath)
+{
+	lt::error_code error;
+	boost::intrusive_ptr<lt::torrent_info> info(
+			new lt::torrent_info(torrent.constData(), torrent.size(), error));
+	if (error)
+		return -1;
+
+	// Neither session needs the DHT, local service discovery or port mapping.
+	lt::session seed(lt::fingerprint("LC", 1, 0, 0, 0), SEED_PORTS, "127.0.0.1", 0);
+	lt::session leech(lt::fingerprint("LC", 1, 0, 0, 0), LEECH_PORTS, "127.0.0.1", 0);
+	for (lt::session *session : {&seed, &leech}) {
+		lt::session_settings settings = session->settings();
+		TorrentSessionProfile::apply(profile, settings);
+		session->set_settings(settings);
+#ifndef TORRENT_DISABLE_ENCRYPTION
+		lt::pe_settings encryption = session->get_pe_settings();
+		TorrentSessionProfile::apply(profile, encryption);
+		session->set_pe_settings(encryption);
+#endif
+	}
+
+	lt::add_torrent_params params;
+	params.ti = info;
+	params.flags &= ~(lt::add_torrent_params::flag_paused
+	                  | lt::add_torrent_params::flag_auto_managed);
+	params.save_path = seedPath.toStdString();
+	params.flags |= lt::add_torrent_params::flag_seed_mode;
+	seed.add_torrent(params, error);
+	if (error)
+		return -1;
+
+	params.save_path = leechPath.toStdString();
+	params.flags &= ~lt::add_torrent_params::flag_seed_mode;
+	const Clock::time_point start = Clock::now();
+	lt::torrent_handle handle = leech.add_torrent(params, error);
+	if (error)
+		return -1;
+	handle.connect_peer(lt::tcp::endpoint(lt::address_v4::loopback(), seed.listen_port()));
+	while (!handle.status().is_seeding) {
+		if (Clock::now() - start > TIMEOUT)
+			return -1;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return nanosSince(start) / 1e6;
+}
@@ -0,0 +1,61 @@
+#include "benchmark.h"
+
+#include <cstdio>
+
+#include <QDir>
+#include <QTemporaryDir>
+
+#include "torrentcreator.h"
+
+
+/**
+ * @brief Measures how fast TorrentCreator hashes a tree.
+ *
+ * The torrent is created with one hashing thread and with all of them. Then
+ * it is created with the PieceHashCache, one file of the tree is changed,
+ * which is 1 % of it, and the torrent is created again. Only the pieces of
+ * that file have to be hashed then. The tree has just been written, so it is
+ * usually read from the page cache of the system and the hashing is the
+ * limit.
+ *
+ * @param treeSize The size of the tree in MiB.
+ */
+void benchmarkTorrentCreator(int treeSize)
+{
+	std::printf("TorrentCreator with %d MiB in %d files\n", treeSize, TREE_FILES);
+	QTemporaryDir dir;
+	const QString treeName = QDir(dir.path()).filePath(QStringLiteral("tree"));
+	const qint64 fileSize = (qint64) treeSize * 1024 * 1024 / TREE_FILES;
+	std::mt19937 random(4);
+	if (!dir.isValid() || !makeTree(treeName, TREE_FILES, fileSize, random)) {
+		std::printf("Could not create the tree\n");
+		return;
+	}
+	const double bytes = (double) fileSize * TREE_FILES;
+
+	TorrentCreator creator;
+	const int threads = creator.threads();
+	creator.setThreads(1);
+	const double single = createTorrent(creator, treeName);
+	creator.setThreads(threads);
+	const double parallel = createTorrent(creator, treeName);
+
+	PieceHashCache *cache = creator.hashCache();
+	cache->setFileName(QDir(dir.path()).filePath(QStringLiteral("piecehashes")));
+	const double cold = createTorrent(creator, treeName);
+	if (!fillFile(QDir(treeName).filePath(QStringLiteral("0")), fileSize, random)) {
+		std::printf("Could not change the tree\n");
+		return;
+	}
+	const std::uint64_t hits = cache->hits();
+	const std::uint64_t misses = cache->misses();
+	const double changed = createTorrent(creator, treeName);
+
+	printThroughput("1 thread", single, bytes);
+	printThroughput(qPrintable(QStringLiteral("%1 threads").arg(threads)), parallel, bytes);
+	printThroughput("cache, all pieces new", cold, bytes);
+	printThroughput("cache, 1 % changed", changed, bytes);
+	std::printf("cache hits %llu, misses %llu after the change\n",
+	            (unsigned long long) (cache->hits() - hits),
+	            (unsigned long long) (cache->misses() - misses));
+}
@@ -0,0 +1,113 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+
+#include "torrent.h"
+#include "torrentindex.h"
+
+namespace lt = libtorrent;
+
+// Lookups timed per size, so small sizes are not dominated by the clock.
+static const int LOOKUPS = 1000000;
+
+
+namespace {
+
+// Torrent without a session, only used as value of the indexes.
+class BenchmarkTorrent : public Torrent
+{
+public:
+	BenchmarkTorrent() : Torrent(nullptr) {}
+};
+
+}
+
+
+/**
+ * @brief Compares TorrentIndex against the std::map TorrentSession used before.
+ *
+ * Every alert of a torrent and every entry of a state update looks up its
+ * torrent, and the status updates iterate over all of them.
+ */
+void benchmarkTorrentIndex()
+{
+	std::printf("TorrentIndex against std::map in ns per torrent\n");
+	std::printf("%9s %10s %10s %10s %10s %10s %10s %10s %10s\n", "torrents",
+	            "map add", "index add", "map find", "index find",
+	            "map miss", "index miss", "map iter", "index iter");
+
+	std::mt19937 random(1);
+	for (const int size : BENCHMARK_SIZES) {
+		const std::vector<lt::sha1_hash> hashes = randomHashes(size, random);
+		const std::vector<lt::sha1_hash> missing = randomHashes(size, random);
+		std::vector<lt::sha1_hash> lookups = hashes;
+		std::shuffle(lookups.begin(), lookups.end(), random);
+		std::vector<std::unique_ptr<Torrent>> mapTorrents;
+		std::vector<std::unique_ptr<Torrent>> indexTorrents;
+		for (int i = 0; i < size; ++i) {
+			mapTorrents.emplace_back(new BenchmarkTorrent);
+			indexTorrents.emplace_back(new BenchmarkTorrent);
+		}
+
+		std::map<lt::sha1_hash, std::unique_ptr<Torrent>> map;
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < size; ++i) {
+			map[hashes[i]] = std::move(mapTorrents[i]);
+		}
+		const double mapAdd = nanosSince(start) / size;
+
+		TorrentIndex index;
+		start = Clock::now();
+		for (int i = 0; i < size; ++i) {
+			index.insert(hashes[i], std::move(indexTorrents[i]));
+		}
+		const double indexAdd = nanosSince(start) / size;
+
+		const int rounds = std::max(1, LOOKUPS / size);
+		auto timeFind = [&](const std::vector<lt::sha1_hash> &keys, bool useIndex) {
+			std::uintptr_t sum = 0;
+			const Clock::time_point findStart = Clock::now();
+			for (int round = 0; round < rounds; ++round) {
+				for (const lt::sha1_hash &key : keys) {
+					if (useIndex) {
+						sum += reinterpret_cast<std::uintptr_t>(index.find(key));
+					} else {
+						const auto it = map.find(key);
+						if (it != map.end())
+							sum += reinterpret_cast<std::uintptr_t>(it->second.get());
+					}
+				}
+			}
+			benchmarkSink = sum;
+			return nanosSince(findStart) / ((double) rounds * keys.size());
+		};
+		const double mapFind = timeFind(lookups, false);
+		const double indexFind = timeFind(lookups, true);
+		const double mapMiss = timeFind(missing, false);
+		const double indexMiss = timeFind(missing, true);
+
+		std::uintptr_t sum = 0;
+		start = Clock::now();
+		for (int round = 0; round < rounds; ++round) {
+			for (const auto &entry : map) {
+				sum += reinterpret_cast<std::uintptr_t>(entry.second.get());
+			}
+		}
+		const double mapIterate = nanosSince(start) / ((double) rounds * size);
+		start = Clock::now();
+		for (int round = 0; round < rounds; ++round) {
+			for (Torrent *torrent : index) {
+				sum += reinterpret_cast<std::uintptr_t>(torrent);
+			}
+		}
+		const double indexIterate = nanosSince(start) / ((double) rounds * size);
+		benchmarkSink = sum;
+
+		std::printf("%9d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", size,
+		            mapAdd, indexAdd, mapFind, indexFind,
+		            mapMiss, indexMiss, mapIterate, indexIterate);
+	}
+}
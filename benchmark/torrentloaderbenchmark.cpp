@@ -0,0 +1,61 @@
+#include "benchmark.h"
+
+#include <cstdio>
+
+#include <QByteArray>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include "messagelistmodel.h"
+#include "torrentcreator.h"
+#include "torrentloader.h"
+
+// Number of torrent files, like a catalog share dropped at once.
+static const int FILES = 200;
+
+
+//! Measures how fast TorrentLoader parses a catalog of torrent files.
+void benchmarkTorrentLoader()
+{
+	std::printf("TorrentLoader with %d torrent files\n", FILES);
+	QTemporaryDir dir;
+	const QString treeName = QDir(dir.path()).filePath(QStringLiteral("tree"));
+	std::mt19937 random(5);
+	QByteArray torrent;
+	TorrentCreator creator;
+	if (!dir.isValid() || !makeTree(treeName, TREE_FILES, 1024 * 1024, random)
+			|| createTorrent(creator, treeName, &torrent) < 0) {
+		std::printf("Could not create the torrent\n");
+		return;
+	}
+
+	QStringList fileNames;
+	for (int i = 0; i < FILES; ++i) {
+		QFile file(QDir(dir.path()).filePath(QStringLiteral("%1.torrent").arg(i)));
+		if (!file.open(QFile::WriteOnly) || file.write(torrent) != torrent.size()) {
+			std::printf("Could not write %s\n", qPrintable(file.fileName()));
+			return;
+		}
+		fileNames << file.fileName();
+	}
+
+	MessageListModel messages;
+	TorrentLoader loader(&messages);
+	QEventLoop loop;
+	QObject::connect(&loader, &TorrentLoader::finished, &loop, &QEventLoop::quit);
+	const Clock::time_point start = Clock::now();
+	loader.loadAll(fileNames);
+	loop.exec();
+	const double total = nanosSince(start) / 1e6;
+
+	const TorrentLoader::Stats &stats = loader.stats();
+	std::printf("%llu files of %d bytes, %llu failed, %.1f ms until delivered\n",
+	            (unsigned long long) stats.files, torrent.size(),
+	            (unsigned long long) stats.failedFiles, total);
+	std::printf("parse %.1f µs average, %llu µs max, %.1f MiB/s\n",
+	            stats.averageParseTime(), (unsigned long long) stats.maxParseTime,
+	            stats.throughput() / 1024 / 1024);
+}
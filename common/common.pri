@@ -10,4 +10,6 @@ DEPENDPATH  += $$PWD
 
 SOURCES += $$PWD/utils.cpp
 
-HEADERS  += $$PWD/utils.h
+HEADERS  += $$PWD/indexedlist.h \
+    $$PWD/spscqueue.h \
+    $$PWD/utils.h
@@ -0,0 +1,317 @@
+#ifndef INDEXEDLIST_H
+#define INDEXEDLIST_H
+
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @brief Sequence of unique values with logarithmic index operations.
+ *
+ * Inserting and removing at any position, looking up the index of a value and
+ * accessing a value by its index take O(log n). The list is a treap whose
+ * nodes know the size of their subtree. A hash map points from the values to
+ * their nodes, so T must be hashable.
+ */
+template<class T>
+class IndexedList
+{
+public:
+	IndexedList() : mRoot(nullptr), mSeed(0x9e3779b9u) {}
+	~IndexedList() {clear();}
+
+	int size() const {return sizeOf(mRoot);}
+	bool isEmpty() const {return mRoot == nullptr;}
+	bool contains(const T &value) const {return mNodes.count(value) != 0;}
+
+	int indexOf(const T &value) const;
+	const T &at(int index) const;
+	const T &operator[](int index) const {return at(index);}
+
+	void insert(int index, const T &value);
+	bool remove(const T &value);
+	void clear();
+
+	template<class Less>
+	int upperBound(const T &value, Less less) const;
+
+	std::vector<T> toVector() const;
+	void assign(const std::vector<T> &values);
+
+private:
+	IndexedList(const IndexedList &) = delete;
+	IndexedList &operator=(const IndexedList &) = delete;
+
+	struct Node {
+		explicit Node(const T &value, std::uint32_t priority) :
+			value(value), parent(nullptr), left(nullptr), right(nullptr),
+			size(1), priority(priority) {}
+		T value;
+		Node *parent;
+		Node *left;
+		Node *right;
+		int size;
+		std::uint32_t priority; // Parents have higher priorities than children.
+	};
+
+	static int sizeOf(const Node *node) {return node ? node->size : 0;}
+	static void updateSize(Node *node)
+	{node->size = sizeOf(node->left) + 1 + sizeOf(node->right);}
+	static void collect(const Node *node, std::vector<T> &values);
+	static int computeSizes(Node *node);
+	std::uint32_t nextPriority();
+	void rotateUp(Node *node);
+
+	Node *mRoot;
+	std::unordered_map<T,Node*> mNodes;
+	std::uint32_t mSeed;
+
+};
+
+// -----------------------------------------------------------------------------
+
+//! Returns the index of the value or -1 if it is not part of the list.
+template<class T>
+int IndexedList<T>::indexOf(const T &value) const
+{
+	auto it = mNodes.find(value);
+	if (it == mNodes.end())
+		return -1;
+	const Node *node = it->second;
+	int index = sizeOf(node->left);
+	for (; node->parent; node = node->parent) {
+		if (node == node->parent->right)
+			index += sizeOf(node->parent->left) + 1;
+	}
+	return index;
+}
+
+template<class T>
+const T &IndexedList<T>::at(int index) const
+{
+	assert(index >= 0 && index < size());
+	const Node *node = mRoot;
+	for (;;) {
+		const int leftSize = sizeOf(node->left);
+		if (index < leftSize) {
+			node = node->left;
+		} else if (index > leftSize) {
+			index -= leftSize + 1;
+			node = node->right;
+		} else {
+			return node->value;
+		}
+	}
+}
+
+//! Inserts the value so that it gets the given index. The value must not be
+//! part of the list yet.
+template<class T>
+void IndexedList<T>::insert(int index, const T &value)
+{
+	assert(index >= 0 && index <= size());
+	assert(!contains(value));
+	Node *node = new Node(value, nextPriority());
+	mNodes.emplace(value, node);
+
+	// Add the node as leaf.
+	if (!mRoot) {
+		mRoot = node;
+		return;
+	}
+	Node *parent = mRoot;
+	for (;;) {
+		++parent->size;
+		const int leftSize = sizeOf(parent->left);
+		if (index <= leftSize) {
+			if (!parent->left) {
+				parent->left = node;
+				break;
+			}
+			parent = parent->left;
+		} else {
+			index -= leftSize + 1;
+			if (!parent->right) {
+				parent->right = node;
+				break;
+			}
+			parent = parent->right;
+		}
+	}
+	node->parent = parent;
+
+	// Restore the heap order of the priorities.
+	while (node->parent && node->priority > node->parent->priority) {
+		rotateUp(node);
+	}
+}
+
+//! Removes the value. Returns <code>false</code> if it was not part of the list.
+template<class T>
+bool IndexedList<T>::remove(const T &value)
+{
+	auto it = mNodes.find(value);
+	if (it == mNodes.end())
+		return false;
+	Node *node = it->second;
+	mNodes.erase(it);
+
+	// Move the node down until it has at most one child.
+	while (node->left && node->right) {
+		rotateUp(node->left->priority > node->right->priority
+		         ? node->left : node->right);
+	}
+	// Replace the node by its child.
+	Node *child = node->left ? node->left : node->right;
+	Node *parent = node->parent;
+	if (child)
+		child->parent = parent;
+	if (!parent)
+		mRoot = child;
+	else if (parent->left == node)
+		parent->left = child;
+	else
+		parent->right = child;
+	for (; parent; parent = parent->parent) {
+		--parent->size;
+	}
+	delete node;
+	return true;
+}
+
+template<class T>
+void IndexedList<T>::clear()
+{
+	for (auto &entry : mNodes) {
+		delete entry.second;
+	}
+	mNodes.clear();
+	mRoot = nullptr;
+}
+
+/**
+ * @brief Returns the index of the first value which is greater than the given
+ * one.
+ *
+ * The list must be sorted regarding less.
+ *
+ * @param value The value to look for.
+ * @param less Returns whether the first argument is less than the second one.
+ */
+template<class T>
+template<class Less>
+int IndexedList<T>::upperBound(const T &value, Less less) const
+{
+	int index = 0;
+	const Node *node = mRoot;
+	while (node) {
+		if (less(value, node->value)) {
+			node = node->left;
+		} else {
+			index += sizeOf(node->left) + 1;
+			node = node->right;
+		}
+	}
+	return index;
+}
+
+//! Returns all values in their order.
+template<class T>
+std::vector<T> IndexedList<T>::toVector() const
+{
+	std::vector<T> values;
+	values.reserve(size());
+	collect(mRoot, values);
+	return values;
+}
+
+//! Replaces the content of the list in O(n). The values must be unique.
+template<class T>
+void IndexedList<T>::assign(const std::vector<T> &values)
+{
+	clear();
+	mNodes.reserve(values.size());
+	// Build the tree with a stack of its right spine.
+	std::vector<Node*> spine;
+	for (const T &value : values) {
+		Node *node = new Node(value, nextPriority());
+		mNodes.emplace(value, node);
+		Node *last = nullptr;
+		while (!spine.empty() && spine.back()->priority < node->priority) {
+			last = spine.back();
+			spine.pop_back();
+		}
+		node->left = last;
+		if (last)
+			last->parent = node;
+		if (!spine.empty()) {
+			spine.back()->right = node;
+			node->parent = spine.back();
+		}
+		spine.push_back(node);
+	}
+	mRoot = spine.empty() ? nullptr : spine.front();
+	computeSizes(mRoot);
+}
+
+template<class T>
+void IndexedList<T>::collect(const Node *node, std::vector<T> &values)
+{
+	if (!node)
+		return;
+	collect(node->left, values);
+	values.push_back(node->value);
+	collect(node->right, values);
+}
+
+template<class T>
+int IndexedList<T>::computeSizes(Node *node)
+{
+	if (!node)
+		return 0;
+	node->size = computeSizes(node->left) + 1 + computeSizes(node->right);
+	return node->size;
+}
+
+template<class T>
+std::uint32_t IndexedList<T>::nextPriority()
+{
+	// xorshift32
+	mSeed ^= mSeed << 13;
+	mSeed ^= mSeed >> 17;
+	mSeed ^= mSeed << 5;
+	return mSeed;
+}
+
+//! Rotates the node above its parent.
+template<class T>
+void IndexedList<T>::rotateUp(Node *node)
+{
+	Node *parent = node->parent;
+	Node *grandparent = parent->parent;
+	if (node == parent->left) {
+		parent->left = node->right;
+		if (node->right)
+			node->right->parent = parent;
+		node->right = parent;
+	} else {
+		parent->right = node->left;
+		if (node->left)
+			node->left->parent = parent;
+		node->left = parent;
+	}
+	parent->parent = node;
+	node->parent = grandparent;
+	if (!grandparent)
+		mRoot = node;
+	else if (grandparent->left == parent)
+		grandparent->left = node;
+	else
+		grandparent->right = node;
+	updateSize(parent);
+	updateSize(node);
+}
+
+#endif // INDEXEDLIST_H
@@ -0,0 +1,79 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+
+/**
+ * @brief Unbounded lock-free queue for a single producer and a single consumer.
+ *
+ * SpscQueue::push must only be called by the producer thread and
+ * SpscQueue::pop must only be called by the consumer thread. The queue is a
+ * linked list whose first node is always a dummy which is owned by the
+ * consumer. The producer only touches the last node.
+ */
+template<class T>
+class SpscQueue
+{
+public:
+	SpscQueue() : mHead(new Node()), mTail(mHead) {}
+	~SpscQueue();
+
+	void push(T value);
+	bool pop(T &value);
+
+private:
+	SpscQueue(const SpscQueue &) = delete;
+	SpscQueue &operator=(const SpscQueue &) = delete;
+
+	struct Node {
+		Node() : next(nullptr) {}
+		explicit Node(T &&value) : next(nullptr), value(std::move(value)) {}
+		std::atomic<Node*> next;
+		T value;
+	};
+
+	// Keep both ends on different cache lines to avoid false sharing.
+	alignas(64) Node *mHead; // Only used by the consumer.
+	alignas(64) Node *mTail; // Only used by the producer.
+
+};
+
+// -----------------------------------------------------------------------------
+
+template<class T>
+SpscQueue<T>::~SpscQueue()
+{
+	while (mHead) {
+		Node *next = mHead->next.load(std::memory_order_relaxed);
+		delete mHead;
+		mHead = next;
+	}
+}
+
+//! Appends a value to the queue. Must only be called by the producer.
+template<class T>
+void SpscQueue<T>::push(T value)
+{
+	Node *node = new Node(std::move(value));
+	mTail->next.store(node, std::memory_order_release);
+	mTail = node;
+}
+
+//! Takes the first value of the queue. Must only be called by the consumer.
+//! Returns <code>false</code> if the queue is empty.
+template<class T>
+bool SpscQueue<T>::pop(T &value)
+{
+	Node *next = mHead->next.load(std::memory_order_acquire);
+	if (next == nullptr)
+		return false;
+	value = std::move(next->value);
+	// The node of the value becomes the new dummy.
+	delete mHead;
+	mHead = next;
+	return true;
+}
+
+#endif // SPSCQUEUE_H
@@ -3,22 +3,33 @@
 
 #include <QAction>
 #include <QCloseEvent>
+#include <QDebug>
 #include <QDesktopServices>
+#include <QDir>
 #include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QMimeData>
+#include <QProgressDialog>
 #include <QSettings>
+#include <QStandardPaths>
 
+#include <libtorrent/add_torrent_params.hpp>
 #include <libtorrent/torrent_info.hpp>
 
 #include "application.h"
 #include "model.h"
 #include "opentorrentdialog.h"
+#include "torrentcreator.h"
+#include "torrentdisksettings.h"
+#include "torrentloader.h"
 #include "torrentlogdialog.h"
+#include "torrentrefreshpolicy.h"
 #include "torrentsession.h"
 #include "torrentsessionstatus.h"
 #include "torrentsmodel.h"
+#include "transmissionview.h"
 #include "trayicon.h"
 #include "utils.h"
 
@@ -30,6 +41,8 @@ MainWindow::MainWindow(QWidget *parent)
 	, ui(new Ui::MainWindow)
 	, settings(new QSettings(this))
 	, logDialog(new TorrentLogDialog(myApp->model(), this))
+	, creator(new TorrentCreator(this))
+	, creationProgress(new QProgressDialog(this))
 {
 	// Get instances of other modules of the application.
 	Application *app = myApp;
@@ -45,12 +58,47 @@ MainWindow::MainWindow(QWidget *parent)
 	fileMenu->addAction(app->newTorrentFromFileAction());
 	fileMenu->addAction(app->newTorrentFromDirAction());
 	fileMenu->addSeparator();
+	fileMenu->addAction(app->lanProfileAction());
+	fileMenu->addAction(tr("&Statistics"), logDialog, SLOT(show()));
+	fileMenu->addSeparator();
 	fileMenu->addAction(app->exitAction());
 
 	// Set model as base for all views.
 	ui->transmissions->setModel(session->torrents()->downloads());
+	// Only query the details of the selected torrent.
+	connect(ui->transmissions, &TransmissionView::currentTorrentChanged,
+	        session, &TorrentSession::setDetailedTorrent);
+
+	// Parse opened torrent files in the background.
+	connect(model->loader(), &TorrentLoader::loaded,
+	        this, &MainWindow::onTorrentLoaded);
+	connect(model->loader(), &TorrentLoader::finished,
+	        this, &MainWindow::onTorrentsLoaded);
 
-	// Read and apply configuration.
+	// Hash new torrents in the background while showing the progress.
+	creationProgress->setWindowTitle(tr("Create torrent"));
+	creationProgress->setRange(0, 1000);
+	creationProgress->setMinimumDuration(0);
+	creationProgress->setAutoClose(false);
+	creationProgress->reset();
+	const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	if (QDir().mkpath(cacheDir))
+		creator->hashCache()->setFileName(cacheDir + QStringLiteral("/piecehashes"));
+	connect(creator, &TorrentCreator::progress,
+	        this, &MainWindow::onTorrentCreationProgress);
+	connect(creator, &TorrentCreator::finished,
+	        this, &MainWindow::onTorrentCreated);
+	connect(creator, &TorrentCreator::failed,
+	        this, &MainWindow::onTorrentCreationFailed);
+	connect(creator, &TorrentCreator::canceled,
+	        this, &MainWindow::onTorrentCreationCanceled);
+	connect(creationProgress, &QProgressDialog::canceled,
+	        creator, &TorrentCreator::cancel);
+
+	// Read and apply configuration. The profile is applied when the setting
+	// is read.
+	connect(app->lanProfileAction(), &QAction::toggled,
+	        this, &MainWindow::onLanProfileToggled);
 	readSettings();
 
 	// Register handlers.
@@ -87,42 +135,44 @@ void MainWindow::openTorrent()
 	                   tr("Torrent Files (*.torrent)"));
 	dialog.setFileMode(QFileDialog::ExistingFiles);
 	if (dialog.exec()) {
-		QStringList fileNames;
-		fileNames = dialog.selectedFiles();
-		for (QString fileName : fileNames) {
-			openTorrent(QUrl::fromLocalFile(fileName));
+		QList<QUrl> urls;
+		for (const QString &fileName : dialog.selectedFiles()) {
+			urls.append(QUrl::fromLocalFile(fileName));
 		}
+		openTorrents(urls);
 	}
 }
 
 void MainWindow::openTorrent(const QUrl &url)
 {
-	std::unique_ptr<lt::torrent_info> info;
-	if (url.isLocalFile()) {
-		QFile file(url.toLocalFile());
-		if (!file.open(QFile::ReadOnly)) {
-			QMessageBox::critical(
-						this,
-						tr("Could not open file"),
-						tr("Could not open file: %1").arg(file.fileName()));
-			return;
-		}
-		QByteArray data = file.readAll();
-		file.close();
-
-		lt::error_code e;
-		info.reset(new lt::torrent_info(data.constData(), data.size(), e));
-	}
+	openTorrents(QList<QUrl>{url});
+}
 
-	OpenTorrentDialog *dialog = new OpenTorrentDialog(this);
-	if (dialog->exec()) {
-		QString savePath = dialog->getSavePath();
-		if (info) {
-			myApp->model()->session()->addTorrent(*info, savePath);
+/**
+ * @brief Opens torrent files and magnet links together.
+ *
+ * Torrent files are parsed by the TorrentLoader in the background. Once all
+ * of them are ready, the user chooses a single save path for all torrents and
+ * they are added to the session at once. Files which cannot be parsed are
+ * reported as messages.
+ */
+void MainWindow::openTorrents(const QList<QUrl> &urls)
+{
+	QStringList fileNames;
+	for (const QUrl &url : urls) {
+		if (url.isLocalFile()) {
+			fileNames.append(url.toLocalFile());
 		} else {
-			myApp->model()->session()->addTorrentMagnet(url, savePath);
+			openedMagnets.append(url);
 		}
 	}
+
+	TorrentLoader *loader = myApp->model()->loader();
+	if (!fileNames.isEmpty()) {
+		loader->loadAll(fileNames);
+	} else if (loader->pending() == 0) {
+		addOpenedTorrents();
+	}
 }
 
 void MainWindow::createTorrentFile()
@@ -147,9 +197,33 @@ void MainWindow::createTorrentDirectory()
 	}
 }
 
+/**
+ * @brief Creates a torrent file for the given file or directory and seeds it.
+ *
+ * The pieces are hashed in the background while a progress dialog is shown.
+ *
+ * @param fileOrDirName The file or directory to share.
+ */
 void MainWindow::createTorrent(const QString &fileOrDirName)
 {
-	// TODO
+	if (creator->isRunning()) {
+		QMessageBox::information(this, tr("Create torrent"),
+		                         tr("Another torrent is being created."));
+		return;
+	}
+	const QFileInfo source(fileOrDirName);
+	const QString fileName = QFileDialog::getSaveFileName(
+				this, tr("Save torrent"),
+				source.absoluteFilePath() + QStringLiteral(".torrent"),
+				tr("Torrent files (*.torrent)"));
+	if (fileName.isEmpty())
+		return;
+
+	creationFileName = fileName;
+	creationProgress->setLabelText(tr("Hashing %1 ...").arg(source.fileName()));
+	creationProgress->reset();
+	creationProgress->show();
+	creator->start(fileOrDirName);
 }
 
 void MainWindow::openOrCreateTorrent(const QString &fileOrDirName)
@@ -168,6 +242,36 @@ void MainWindow::closeEvent(QCloseEvent *event)
 	hide();
 }
 
+void MainWindow::showEvent(QShowEvent *event)
+{
+	QMainWindow::showEvent(event);
+	updateRefreshPolicy();
+}
+
+void MainWindow::hideEvent(QHideEvent *event)
+{
+	QMainWindow::hideEvent(event);
+	updateRefreshPolicy();
+}
+
+void MainWindow::changeEvent(QEvent *event)
+{
+	QMainWindow::changeEvent(event);
+	if (event->type() == QEvent::ActivationChange
+			|| event->type() == QEvent::WindowStateChange)
+		updateRefreshPolicy();
+}
+
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+	QMainWindow::paintEvent(event);
+	// Measure how long the user had to wait for the window.
+	if (!painted) {
+		painted = true;
+		myApp->model()->session()->reportFirstFrame();
+	}
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 {
 	if (event->possibleActions() & Qt::CopyAction) {
@@ -182,14 +286,19 @@ void MainWindow::dropEvent(QDropEvent *event)
 {
 	if (event->dropAction() == Qt::CopyAction && event->mimeData()->hasUrls()) {
 		event->accept();
-		// TODO is it a good idea to make a function call for every element?
-		for (QUrl url : event->mimeData()->urls()) {
-			if (url.isLocalFile()) {
-				openOrCreateTorrent(url.toLocalFile());
+		// Open all dropped torrents together and create torrents for the
+		// other files.
+		QList<QUrl> torrents;
+		for (const QUrl &url : event->mimeData()->urls()) {
+			if (url.isLocalFile()
+					&& !url.toLocalFile().endsWith(".torrent", Qt::CaseInsensitive)) {
+				createTorrent(url.toLocalFile());
 			} else {
-				openTorrent(url);
+				torrents.append(url);
 			}
 		}
+		if (!torrents.isEmpty())
+			openTorrents(torrents);
 	}
 }
 
@@ -200,11 +309,83 @@ void MainWindow::onSessionUpdate()
 	ui->uploadRate->setText(Utils::makeSpeedStr(s->payloadUploadRate()));
 }
 
+void MainWindow::onTorrentLoaded(const QString &,
+			boost::intrusive_ptr<lt::torrent_info> info)
+{
+	openedTorrents.push_back(info);
+}
+
+void MainWindow::onTorrentsLoaded()
+{
+	addOpenedTorrents();
+}
+
+void MainWindow::onLanProfileToggled(bool enabled)
+{
+	myApp->model()->session()->setProfile(enabled ? TorrentSession::LanProfile
+	                                               : TorrentSession::InternetProfile);
+}
+
+//! Tells the refresh policy of the session whether the user can see the window.
+void MainWindow::updateRefreshPolicy()
+{
+	TorrentRefreshPolicy *policy = myApp->model()->session()->refreshPolicy();
+	policy->setWindowVisible(isVisible() && !isMinimized());
+	policy->setWindowActive(isActiveWindow());
+}
+
 void MainWindow::onShutdown()
 {
 	// TODO show some overlay.
 }
 
+void MainWindow::onTorrentCreationProgress(qint64 bytesHashed, qint64 bytesTotal)
+{
+	if (creationProgress->isVisible())
+		creationProgress->setValue(bytesHashed * 1000 / bytesTotal);
+}
+
+void MainWindow::onTorrentCreated(const QByteArray &torrent)
+{
+	creationProgress->reset();
+	creationProgress->hide();
+	// Save the torrent file.
+	QFile file(creationFileName);
+	if (!file.open(QFile::WriteOnly) || file.write(torrent) != torrent.size()) {
+		QMessageBox::critical(this, tr("Could not save torrent"),
+		                      tr("Could not save %1: %2")
+		                      .arg(creationFileName, file.errorString()));
+		return;
+	}
+	file.close();
+
+	// The pieces have just been hashed, so seed without checking them again.
+	lt::error_code error;
+	boost::intrusive_ptr<lt::torrent_info> info(
+				new lt::torrent_info(torrent.constData(), torrent.size(), error));
+	if (error) {
+		QMessageBox::critical(this, tr("Could not load torrent"),
+		                      QString::fromStdString(error.message()));
+		return;
+	}
+	myApp->model()->session()->addTorrent(
+				info, QFileInfo(creator->fileOrDirName()).absolutePath(),
+				lt::add_torrent_params::flag_seed_mode);
+}
+
+void MainWindow::onTorrentCreationFailed(const QString &error)
+{
+	creationProgress->reset();
+	creationProgress->hide();
+	QMessageBox::critical(this, tr("Could not create torrent"), error);
+}
+
+void MainWindow::onTorrentCreationCanceled()
+{
+	creationProgress->reset();
+	creationProgress->hide();
+}
+
 //void MainWindow::commitData(QSessionManager &)
 //{
 //	writeSettings();
@@ -264,6 +445,40 @@ void MainWindow::readSettings()
 	resize(settings->value("size", size()).toSize());
 	move(settings->value("pos", pos()).toPoint());
 	settings->endGroup();
+	settings->beginGroup("Session");
+	myApp->lanProfileAction()->setChecked(settings->value("lanProfile", true).toBool());
+	// Reserving whole files delays the first piece of large torrents.
+	myApp->model()->session()->setDefaultAllocation(
+				settings->value("allocation").toString() == QLatin1String("full")
+				? TorrentSession::FullAllocation : TorrentSession::SparseAllocation);
+	// Peers of the local network are never throttled.
+	TorrentNetworkPolicy policy;
+	for (const QString &subnet : settings->value("localSubnets").toStringList()) {
+		if (!policy.addSubnet(subnet.toStdString()))
+			qWarning() << "Ignoring invalid local subnet" << subnet;
+	}
+	policy.wanDownloadLimit = settings->value("wanDownloadLimit", 0).toInt();
+	policy.wanUploadLimit = settings->value("wanUploadLimit", 0).toInt();
+	policy.wanBlocked = settings->value("wanBlocked", false).toBool();
+	myApp->model()->session()->setNetworkPolicy(policy);
+	settings->endGroup();
+	// Tune the disk I/O with a preset and single values.
+	settings->beginGroup("Disk");
+	TorrentDiskSettings disk;
+	TorrentDiskSettings::Preset preset;
+	const QString presetName = settings->value("preset").toString();
+	if (TorrentDiskSettings::presetFromName(presetName, preset))
+		disk = TorrentDiskSettings::fromPreset(preset);
+	else if (!presetName.isEmpty())
+		qWarning() << "Ignoring unknown disk preset" << presetName;
+	disk.cacheSize = settings->value("cacheSize", disk.cacheSize).toInt();
+	disk.cacheExpiry = settings->value("cacheExpiry", disk.cacheExpiry).toInt();
+	disk.aioThreads = settings->value("aioThreads", disk.aioThreads).toInt();
+	disk.hashingThreads = settings->value("hashingThreads", disk.hashingThreads).toInt();
+	disk.filePoolSize = settings->value("filePoolSize", disk.filePoolSize).toInt();
+	disk.readAhead = settings->value("readAhead", disk.readAhead).toInt();
+	myApp->model()->session()->setDiskSettings(disk);
+	settings->endGroup();
 }
 
 void MainWindow::writeSettings()
@@ -272,4 +487,47 @@ void MainWindow::writeSettings()
 	settings->setValue("size", size());
 	settings->setValue("pos", pos());
 	settings->endGroup();
+	settings->beginGroup("Session");
+	settings->setValue("lanProfile", myApp->lanProfileAction()->isChecked());
+	settings->endGroup();
+}
+
+/**
+ * @brief Asks once for the save path of all opened torrents and adds them.
+ *
+ * The torrent files are added to the session with a single call.
+ */
+void MainWindow::addOpenedTorrents()
+{
+	// The dialog runs an event loop, so more torrents may be loaded while it
+	// is shown. They are asked for once it is closed instead of opening
+	// another dialog on top of it.
+	if (addingTorrents)
+		return;
+	addingTorrents = true;
+	for (;;) {
+		std::vector<boost::intrusive_ptr<lt::torrent_info>> torrents;
+		torrents.swap(openedTorrents);
+		QList<QUrl> magnets;
+		magnets.swap(openedMagnets);
+		if (torrents.empty() && magnets.isEmpty())
+			break;
+
+		OpenTorrentDialog dialog(this);
+		dialog.setTorrentCount(torrents.size() + magnets.size());
+		if (dialog.exec()) {
+			const QString savePath = dialog.getSavePath();
+			TorrentSession *session = myApp->model()->session();
+			if (!torrents.empty() && session->addTorrents(torrents, savePath).isEmpty()) {
+				QMessageBox::critical(
+							this,
+							tr("Not enough free space"),
+							tr("The torrents do not fit into %1.").arg(savePath));
+			}
+			for (const QUrl &magnet : magnets) {
+				session->addTorrentMagnet(magnet, savePath);
+			}
+		}
+	}
+	addingTorrents = false;
 }
@@ -1,19 +1,29 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <vector>
+
+#include <boost/intrusive_ptr.hpp>
+
+#include <QList>
 #include <QMainWindow>
+#include <QUrl>
 
 #include "model.h"
 #include "torrentlogdialog.h"
 
 QT_BEGIN_NAMESPACE
 class QFile;
+class QProgressDialog;
 class QSessionManager;
 class QSettings;
-class QUrl;
 QT_END_NAMESPACE
+namespace libtorrent {
+class torrent_info;
+}
 class Application;
 class Model;
+class TorrentCreator;
 class TorrentLogDialog;
 
 namespace Ui {
@@ -32,6 +42,7 @@ public:
 public slots:
 	void openTorrent();
 	void openTorrent(const QUrl &url);
+	void openTorrents(const QList<QUrl> &urls);
 	void createTorrentFile();
 	void createTorrentDirectory();
 	void createTorrent(const QString &fileOrDirName);
@@ -39,12 +50,25 @@ public slots:
 
 protected:
 	virtual void closeEvent(QCloseEvent *event) override;
+	virtual void showEvent(QShowEvent *event) override;
+	virtual void hideEvent(QHideEvent *event) override;
+	virtual void changeEvent(QEvent *event) override;
+	virtual void paintEvent(QPaintEvent *event) override;
 	virtual void dragEnterEvent(QDragEnterEvent *event) override;
 	virtual void dropEvent(QDropEvent *event) override;
 
 private slots:
 	void onSessionUpdate();
 	void onShutdown();
+	void onLanProfileToggled(bool enabled);
+	void onTorrentLoaded(const QString &fileName,
+	                     boost::intrusive_ptr<libtorrent::torrent_info> info);
+	void onTorrentsLoaded();
+	void onTorrentCreationProgress(qint64 bytesHashed, qint64 bytesTotal);
+	void onTorrentCreated(const QByteArray &torrent);
+	void onTorrentCreationFailed(const QString &error);
+	void onTorrentCreationCanceled();
+	void updateRefreshPolicy();
 
 // TODO Should I use them?
 //	void commitData(QSessionManager &);
@@ -52,11 +76,21 @@ private slots:
 private:
 	void readSettings();
 	void writeSettings();
+	void addOpenedTorrents();
 
 	Ui::MainWindow * const ui;
 	QSettings * const settings;
 
 	TorrentLogDialog * const logDialog;
+	TorrentCreator * const creator;
+	QProgressDialog * const creationProgress;
+	QString creationFileName;
+	bool painted = false;
+	// Whether addOpenedTorrents is showing its dialog.
+	bool addingTorrents = false;
+	// Torrents which are added together once all opened files are loaded.
+	std::vector<boost::intrusive_ptr<libtorrent::torrent_info>> openedTorrents;
+	QList<QUrl> openedMagnets;
 
 };
 
@@ -22,6 +22,12 @@ QString OpenTorrentDialog::getSavePath()
 	return ui->lineEdit->text();
 }
 
+//! Shows how many torrents are saved in the selected directory.
+void OpenTorrentDialog::setTorrentCount(int count)
+{
+	setWindowTitle(tr("Open %n torrent(s)", "", count));
+}
+
 void OpenTorrentDialog::accept()
 {
 	QDir dir (ui->lineEdit->text());
@@ -16,6 +16,7 @@ public:
 	virtual ~OpenTorrentDialog();
 
 	QString getSavePath();
+	void setTorrentCount(int count);
 
 public slots:
 	void accept() override;
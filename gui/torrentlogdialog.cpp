@@ -1,12 +1,104 @@
 #include "torrentlogdialog.h"
 
+#include <QPlainTextEdit>
+#include <QTextStream>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "torrentloader.h"
+#include "torrentsession.h"
+
+// Interval in which the shown counters are refreshed.
+static const int UPDATE_INTERVAL = 1000;
+
 
 TorrentLogDialog::TorrentLogDialog(Model *model, QWidget *parent) :
-	QWidget(parent),
-	model(model)
+	QWidget(parent, Qt::Window),
+	model(model),
+	text(new QPlainTextEdit(this)),
+	timer(new QTimer(this))
 {
+	setWindowTitle(tr("Statistics"));
+	text->setReadOnly(true);
+	text->setLineWrapMode(QPlainTextEdit::NoWrap);
+	QVBoxLayout *layout = new QVBoxLayout(this);
+	layout->addWidget(text);
+	resize(480, 560);
+
+	timer->setInterval(UPDATE_INTERVAL);
+	connect(timer, SIGNAL(timeout()), this, SLOT(updateMetrics()));
 }
 
 TorrentLogDialog::~TorrentLogDialog()
 {
 }
+
+void TorrentLogDialog::showEvent(QShowEvent *event)
+{
+	updateMetrics();
+	timer->start();
+	QWidget::showEvent(event);
+}
+
+void TorrentLogDialog::hideEvent(QHideEvent *event)
+{
+	timer->stop();
+	QWidget::hideEvent(event);
+}
+
+void TorrentLogDialog::updateMetrics()
+{
+	const TorrentSessionMetrics m = model->session()->metrics();
+	const TorrentLoader::Stats &loader = model->loader()->stats();
+
+	QString str;
+	QTextStream out(&str);
+	out << tr("Alerts") << '\n'
+	    << "  " << tr("Handled: %1").arg(m.alerts) << '\n'
+	    << "  " << tr("Queue drains: %1 (%2 idle)").arg(m.alertTicks).arg(m.idleAlertTicks) << '\n'
+	    << "  " << tr("Latency: %1 µs average, %2 µs max")
+	               .arg(m.averageAlertLatency(), 0, 'f', 1).arg(m.alertLatencyMax) << '\n'
+	    << tr("Status requests") << '\n'
+	    << "  " << tr("Fast: %1, normal: %2, hidden: %3, dormant: %4")
+	               .arg(m.fastStatusRequests).arg(m.normalStatusRequests)
+	               .arg(m.hiddenStatusRequests).arg(m.dormantStatusRequests) << '\n'
+	    << "  " << tr("Interval: %1 ms (%2 changes)")
+	               .arg(m.statusInterval).arg(m.statusIntervalChanges) << '\n'
+	    << tr("Startup") << '\n'
+	    << "  " << tr("Resumed torrents: %1").arg(m.resumedTorrents) << '\n'
+	    << "  " << tr("First frame: %1 ms").arg(m.startupToFirstFrameTime) << '\n'
+	    << "  " << tr("Resume data checked: %1 ms").arg(m.startupToSeedingTime) << '\n'
+	    << tr("Resume store") << '\n'
+	    << "  " << tr("Files written: %1 in %2 batches")
+	               .arg(m.resumeWrites).arg(m.resumeBatches) << '\n'
+	    << tr("Metadata") << '\n'
+	    << "  " << tr("Torrents: %1, %2 bytes (%3 bytes per torrent)")
+	               .arg(m.metadataTorrents).arg(m.metadataBytes)
+	               .arg(m.metadataBytesSavedPerTorrent(), 0, 'f', 0) << '\n'
+	    << tr("First byte") << '\n'
+	    << "  " << tr("Sparse files: %1 torrents, %2 ms average")
+	               .arg(m.sparseFirstByteTorrents)
+	               .arg(m.averageSparseFirstByteTime(), 0, 'f', 0) << '\n'
+	    << "  " << tr("Allocated files: %1 torrents, %2 ms average")
+	               .arg(m.fullFirstByteTorrents)
+	               .arg(m.averageFullFirstByteTime(), 0, 'f', 0) << '\n'
+	    << "  " << tr("Streams: %1, %2 ms average")
+	               .arg(m.streamFirstBytes)
+	               .arg(m.averageStreamFirstBytesTime(), 0, 'f', 0) << '\n'
+	    << tr("Finished torrents") << '\n'
+	    << "  " << tr("Streamed: %1, %2 bytes in %3 s (%4 bytes/s)")
+	               .arg(m.streamedTorrents).arg(m.streamedBytes).arg(m.streamedTime)
+	               .arg(m.streamedThroughput(), 0, 'f', 0) << '\n'
+	    << "  " << tr("Downloaded: %1, %2 bytes in %3 s (%4 bytes/s)")
+	               .arg(m.downloadedTorrents).arg(m.downloadedBytes).arg(m.downloadedTime)
+	               .arg(m.downloadedThroughput(), 0, 'f', 0) << '\n'
+	    << tr("Torrent files") << '\n'
+	    << "  " << tr("Parsed: %1 (%2 failed), %3 pending")
+	               .arg(loader.files).arg(loader.failedFiles).arg(model->loader()->pending()) << '\n'
+	    << "  " << tr("Parse time: %1 µs average, %2 µs max")
+	               .arg(loader.averageParseTime(), 0, 'f', 0).arg(loader.maxParseTime) << '\n'
+	    << "  " << tr("Throughput: %1 bytes/s").arg(loader.throughput(), 0, 'f', 0) << '\n';
+	out.flush();
+
+	text->setPlainText(str);
+}
@@ -5,7 +5,13 @@
 
 #include "model.h"
 
+QT_BEGIN_NAMESPACE
+class QPlainTextEdit;
+class QTimer;
+QT_END_NAMESPACE
 
+
+//! Window which shows the counters of the session and the torrent loader.
 class TorrentLogDialog : public QWidget
 {
 	Q_OBJECT
@@ -13,8 +19,17 @@ public:
 	explicit TorrentLogDialog(Model *model, QWidget *parent = 0);
 	virtual ~TorrentLogDialog();
 
+protected:
+	virtual void showEvent(QShowEvent *event) override;
+	virtual void hideEvent(QHideEvent *event) override;
+
+private slots:
+	void updateMetrics();
+
 private:
 	Model * const model;
+	QPlainTextEdit * const text;
+	QTimer * const timer;
 
 };
 
@@ -1,9 +1,19 @@
 #include "transmissionview.h"
 
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
 #include <QApplication>
+#include <QHash>
+#include <QItemSelectionModel>
 #include <QIdentityProxyModel>
 #include <QMetaEnum>
+#include <QMetaObject>
+#include <QPair>
+#include <QScrollBar>
 #include <QStyledItemDelegate>
+#include <QVector>
 
 #include "torrent.h"
 #include "torrentinfo.h"
@@ -75,16 +85,53 @@ class TransmissionViewProxy : public QIdentityProxyModel
 	Q_OBJECT
 public:
 	TransmissionViewProxy(TransmissionView *transmissionView)
-		: QIdentityProxyModel(transmissionView)
+		: QIdentityProxyModel(transmissionView), mFlushPending(false)
+		, mViewVisible(false), mFirstVisibleRow(0), mLastVisibleRow(-1)
 	{
-		connect(this, &TransmissionViewProxy::rowsInserted,
-		        this, &TransmissionViewProxy::onRowsInserted);
-		connect(this, &TransmissionViewProxy::rowsAboutToBeRemoved,
-		        this, &TransmissionViewProxy::onRowsAboutToBeRemoved);
-		connect(this, &TransmissionViewProxy::modelReset,
-		        this, &TransmissionViewProxy::onModelReset);
-		connect(this, &TransmissionViewProxy::modelAboutToBeReset,
-		        this, &TransmissionViewProxy::onModelAboutToBeReset);
+	}
+
+	/**
+	 * @brief Sets the rows which are currently shown by the view.
+	 *
+	 * Changes of other rows are not propagated. The view requests fresh data
+	 * anyway when it paints rows which scroll into view.
+	 *
+	 * @param first The first visible row.
+	 * @param last The last visible row. Use std::numeric_limits<int>::max() if the view shows
+	 *        everything up to the end of the model.
+	 */
+	void setVisibleRows(int first, int last)
+	{
+		mFirstVisibleRow = first;
+		mLastVisibleRow = last;
+	}
+
+	/**
+	 * @brief Sets whether the view is visible.
+	 *
+	 * Status updates are ignored while the view is hidden, e.g. when the
+	 * window is minimized or hidden to the tray. It is repainted with fresh
+	 * data when it is shown again.
+	 */
+	void setViewVisible(bool visible)
+	{
+		mViewVisible = visible;
+		if (!visible)
+			mDirtyTorrents.clear();
+	}
+
+	void setSourceModel(QAbstractItemModel *model) override
+	{
+		assert(dynamic_cast<TorrentsModelBase*>(model));
+		// Stay up to date with the status of the torrents.
+		if (sourceModel()) {
+			disconnect(static_cast<TorrentsModelBase*>(sourceModel()), &TorrentsModelBase::torrentsUpdated,
+			           this, &TransmissionViewProxy::onTorrentsUpdated);
+		}
+		mDirtyTorrents.clear();
+		QIdentityProxyModel::setSourceModel(model);
+		connect(static_cast<TorrentsModelBase*>(model), &TorrentsModelBase::torrentsUpdated,
+		        this, &TransmissionViewProxy::onTorrentsUpdated);
 	}
 
 	int columnCount(const QModelIndex & = QModelIndex()) const override
@@ -137,8 +184,8 @@ public:
 		case 3:
 			switch (role) {
 			case Qt::DisplayRole: return Utils::makeSpeedStr(s->downloadPayloadRate());
-			case TransferSpeedRole: return s->uploadPayloadRate();
-			case TransferSpeedEffectivityRole: return (double) s->uploadPayloadRate() / s->uploadRate();
+			case TransferSpeedRole: return s->downloadPayloadRate();
+			case TransferSpeedEffectivityRole: return (double) s->downloadPayloadRate() / s->downloadRate();
 			default: return QVariant();
 			}
 		case 4:
@@ -188,56 +235,78 @@ public:
 	}
 
 private slots:
-	void onRowsInserted(const QModelIndex &parent, int first, int last)
+	void onTorrentsUpdated(const QVector<Torrent*> &torrents)
 	{
-		if (parent.isValid())
+		// Nothing is painted while hidden.
+		if (!mViewVisible)
 			return;
-
-		for (int row = first; row <= last; ++row) {
-			Torrent *torrent = getTorrent(row);
-			connect(torrent, &Torrent::statusUpdated,
-			        this, &TransmissionViewProxy::onTorrentStatusUpdate);
+		// Remember what has changed and propagate it once the event loop
+		// continues. Updates of the same turn are merged.
+		for (Torrent *t : torrents) {
+			mDirtyTorrents[t] |= t->status()->changedFields();
 		}
-	}
-
-	void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
-	{
-		if (parent.isValid())
-			return;
-
-		for (int row = first; row <= last; ++row) {
-			Torrent *torrent = getTorrent(row);
-			disconnect(torrent, &Torrent::statusUpdated,
-			           this, &TransmissionViewProxy::onTorrentStatusUpdate);
+		if (!mFlushPending && !mDirtyTorrents.isEmpty()) {
+			mFlushPending = true;
+			QMetaObject::invokeMethod(this, "flushChanges", Qt::QueuedConnection);
 		}
 	}
 
-	void onModelReset()
-	{
-		// Act as if every torrent would be new.
-		onRowsInserted(QModelIndex(), 0, rowCount() - 1);
-	}
-
-	void onModelAboutToBeReset()
-	{
-		// Act as if every torrent will be removed.
-		onRowsAboutToBeRemoved(QModelIndex(), 0, rowCount() - 1);
-	}
-
-	void onTorrentStatusUpdate()
+	void flushChanges()
 	{
+		mFlushPending = false;
+		if (mDirtyTorrents.isEmpty())
+			return;
 		// Assertions.
-		assert(dynamic_cast<Torrent*>(sender()));
 		assert(dynamic_cast<TorrentsModelBase*>(sourceModel()));
-		// Get torrent and underlying model.
-		Torrent *t = static_cast<Torrent*>(sender());
+		// Get the underlying model.
 		TorrentsModelBase *torrentsModel = static_cast<TorrentsModelBase*>(sourceModel());
-		// Get the row from the underlying model and emit signal to propagate changes.
-		int row = torrentsModel->rowFromTorrent(t);
-		dataChanged(index(row, 1), index(row, 7));
+		// Get the visible rows from the underlying model. Torrents may have
+		// been removed meanwhile. Rows which are out of view are stale until
+		// they are painted again.
+		QVector<QPair<int,TorrentStatus::Fields>> rows;
+		rows.reserve(mDirtyTorrents.size());
+		for (auto it = mDirtyTorrents.cbegin(); it != mDirtyTorrents.cend(); ++it) {
+			const int row = torrentsModel->rowFromTorrent(it.key());
+			if (row >= mFirstVisibleRow && row <= mLastVisibleRow && it.value())
+				rows.append(qMakePair(row, it.value()));
+		}
+		mDirtyTorrents.clear();
+		std::sort(rows.begin(), rows.end(),
+		          [](const QPair<int,TorrentStatus::Fields> &r1,
+		             const QPair<int,TorrentStatus::Fields> &r2) {
+			return r1.first < r2.first;
+		});
+		// Emit one signal for every range of adjacent rows. It covers the
+		// columns and roles which changed in any of these rows.
+		for (int i = 0; i < rows.size();) {
+			const int first = rows[i].first;
+			TorrentStatus::Fields fields = rows[i].second;
+			int last = first;
+			for (++i; i < rows.size() && rows[i].first == last + 1; ++i) {
+				fields |= rows[i].second;
+				++last;
+			}
+			emitDataChanged(first, last, fields);
+		}
 	}
 
 private:
+	//! Returns the status fields which are shown in the column.
+	static TorrentStatus::Fields columnFields(int column)
+	{
+		switch (column) {
+		case 1: return TorrentStatus::StateField;
+		case 2: return TorrentStatus::ProgressPPMField;
+		case 3: return TorrentStatus::DownloadPayloadRateField | TorrentStatus::DownloadRateField;
+		case 4: return TorrentStatus::UploadPayloadRateField | TorrentStatus::UploadRateField;
+		case 5: return TorrentStatus::PeersField | TorrentStatus::SeedsField;
+		case 6: return TorrentStatus::SavePathField;
+		case 7: return TorrentStatus::CurrentTrackerField;
+		default: return TorrentStatus::Fields();
+		}
+	}
+
+public:
 	Torrent *getTorrent(int row) const
 	{
 		QModelIndex index = sourceModel()->index(row, 0);
@@ -246,6 +315,45 @@ private:
 		assert(t);
 		return t;
 	}
+
+private:
+	//! Returns the roles which depend on the status in the column.
+	static QVector<int> columnRoles(int column)
+	{
+		switch (column) {
+		case 2: return {Qt::DisplayRole, ProgressRole};
+		case 3:
+		case 4: return {Qt::DisplayRole, TransferSpeedRole, TransferSpeedEffectivityRole};
+		default: return {Qt::DisplayRole};
+		}
+	}
+
+	void emitDataChanged(int firstRow, int lastRow, TorrentStatus::Fields fields)
+	{
+		int firstColumn = -1;
+		int lastColumn = -1;
+		QVector<int> roles;
+		for (int column = 1; column < columnCount(); ++column) {
+			if (!(fields & columnFields(column)))
+				continue;
+			if (firstColumn < 0)
+				firstColumn = column;
+			lastColumn = column;
+			for (int role : columnRoles(column)) {
+				if (!roles.contains(role))
+					roles.append(role);
+			}
+		}
+		if (firstColumn >= 0) {
+			dataChanged(index(firstRow, firstColumn), index(lastRow, lastColumn), roles);
+		}
+	}
+
+	QHash<Torrent*,TorrentStatus::Fields> mDirtyTorrents;
+	bool mFlushPending;
+	bool mViewVisible;
+	int mFirstVisibleRow;
+	int mLastVisibleRow;
 };
 
 TransmissionView::TransmissionView(QWidget *parent)
@@ -259,12 +367,63 @@ TransmissionView::TransmissionView(QWidget *parent)
 	// Set some properties.
 	setAlternatingRowColors(true);
 	setSelectionBehavior(QAbstractItemView::SelectRows);
+
+	// Track which rows are on screen.
+	connect(verticalScrollBar(), &QScrollBar::valueChanged,
+	        this, &TransmissionView::updateVisibleRows);
+	connect(verticalScrollBar(), &QScrollBar::rangeChanged,
+	        this, &TransmissionView::updateVisibleRows);
+	connect(selectionModel(), &QItemSelectionModel::currentRowChanged,
+	        this, &TransmissionView::onCurrentRowChanged);
 }
 
 void TransmissionView::setModel(QAbstractItemModel *model)
 {
 	assert(dynamic_cast<TorrentsModelBase*>(model));
 	proxyModel->setSourceModel(model);
+	updateVisibleRows();
+	currentTorrentChanged(currentTorrent());
+}
+
+//! Returns the torrent of the current row or <code>nullptr</code>.
+Torrent *TransmissionView::currentTorrent() const
+{
+	const QModelIndex index = currentIndex();
+	return index.isValid() ? proxyModel->getTorrent(index.row()) : nullptr;
+}
+
+void TransmissionView::showEvent(QShowEvent *event)
+{
+	QTableView::showEvent(event);
+	proxyModel->setViewVisible(true);
+	updateVisibleRows();
+}
+
+void TransmissionView::hideEvent(QHideEvent *event)
+{
+	QTableView::hideEvent(event);
+	proxyModel->setViewVisible(false);
+}
+
+void TransmissionView::resizeEvent(QResizeEvent *event)
+{
+	QTableView::resizeEvent(event);
+	updateVisibleRows();
+}
+
+void TransmissionView::updateVisibleRows()
+{
+	const int first = rowAt(0);
+	const int last = rowAt(viewport()->height() - 1);
+	// rowAt returns -1 below the last row. The view shows everything up to
+	// the end in this case, including rows which are added later.
+	proxyModel->setVisibleRows(std::max(first, 0),
+	                           last < 0 ? std::numeric_limits<int>::max() : last);
+}
+
+void TransmissionView::onCurrentRowChanged()
+{
+	currentTorrentChanged(currentTorrent());
 }
 
 #include "transmissionview.moc"
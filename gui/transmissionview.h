@@ -3,6 +3,7 @@
 
 #include <QTableView>
 
+class Torrent;
 class TorrentsModel;
 class TransmissionViewDelegate;
 class TransmissionViewProxy;
@@ -17,6 +18,20 @@ public:
 	//! Sets the model for the view. You should only use instances of TorrentsModel here.
 	void setModel(QAbstractItemModel *model) override;
 
+	Torrent *currentTorrent() const;
+
+signals:
+	void currentTorrentChanged(Torrent *torrent);
+
+protected:
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+	void updateVisibleRows();
+	void onCurrentRowChanged();
+
 private:
 	TransmissionViewDelegate *delegate;
 	TransmissionViewProxy *proxyModel;
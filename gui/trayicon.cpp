@@ -10,6 +10,7 @@
 #include "message.h"
 #include "messagelistmodel.h"
 #include "model.h"
+#include "torrentrefreshpolicy.h"
 #include "torrentsession.h"
 #include "torrentsessionstatus.h"
 #include "torrentsmodel.h"
@@ -30,6 +31,7 @@ TrayIcon::TrayIcon(QObject *parent)
 	mMenu->addAction(app->openTorrentAction());
 	mMenu->addAction(app->newTorrentFromFileAction());
 	mMenu->addAction(app->newTorrentFromDirAction());
+	mMenu->addAction(app->lanProfileAction());
 	mMenu->addSeparator();
 	mStatusAction1 = mMenu->addAction(QStringLiteral(""));
 	mStatusAction2 = mMenu->addAction(QStringLiteral(""));
@@ -49,9 +51,14 @@ TrayIcon::TrayIcon(QObject *parent)
 	        this, &TrayIcon::onMessageAdded);
 	connect(this, &TrayIcon::messageClicked,
 	        this, &TrayIcon::onMessageClicked);
-	// Update information in context menu when the user opens it.
+	// Update information in context menu when the user opens it and as long
+	// as it stays open.
 	connect(mMenu.get(), &QMenu::aboutToShow,
-	        this, &TrayIcon::updateSssionInfo);
+	        this, &TrayIcon::onMenuAboutToShow);
+	connect(mMenu.get(), &QMenu::aboutToHide,
+	        this, &TrayIcon::onMenuAboutToHide);
+	connect(app->model()->session(), &TorrentSession::statusUpdated,
+	        this, &TrayIcon::onSessionUpdate);
 
 	// Show tray icon.
 	this->show();
@@ -140,6 +147,17 @@ void TrayIcon::onSessionUpdate()
 		updateSssionInfo();
 }
 
+void TrayIcon::onMenuAboutToShow()
+{
+	updateSssionInfo();
+	myApp->model()->session()->refreshPolicy()->setTrayMenuVisible(true);
+}
+
+void TrayIcon::onMenuAboutToHide()
+{
+	myApp->model()->session()->refreshPolicy()->setTrayMenuVisible(false);
+}
+
 void TrayIcon::updateState()
 {
 	if (mMessage == nullptr) {
@@ -29,6 +29,8 @@ private slots:
 	void onMessageDestroyed();
 	void onMessageNoticedChanged();
 	void onSessionUpdate();
+	void onMenuAboutToShow();
+	void onMenuAboutToHide();
 
 	void updateState();
 	void updateSssionInfo();
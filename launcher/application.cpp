@@ -11,6 +11,7 @@
 #include "localapplicationserver.h"
 #include "mainwindow.h"
 #include "model.h"
+#include "torrentsession.h"
 #include "trayicon.h"
 
 
@@ -30,7 +31,7 @@ public slots:
 
 private:
 	LocalApplicationServer *mApplicationServer;
-	Model *mModel;
+	Model *mModel = nullptr;
 	// Set to null to protect for SEGV on destruction if MainWindow is not created.
 	MainWindow *mMainWindow = nullptr;
 	TrayIcon *mTrayIcon;
@@ -98,12 +99,16 @@ Application::Application(int &argc, char **argv)
 	mOpenTorrentAction        = new QAction(QIcon(QStringLiteral(":/icons/open")),    tr("&Open torrent"), this);
 	mNewTorrentFromFileAction = new QAction(QIcon(QStringLiteral(":/icons/newFile")), tr("New torrent from &file"), this);
 	mNewTorrentFromDirAction  = new QAction(QIcon(QStringLiteral(":/icons/newDir")),  tr("New torrent from &directory"), this);
+	mLanProfileAction         = new QAction(tr("&LAN mode"), this);
 
 	// Set some properties of created options.
 	mExitAction->setToolTip(tr("Just quits the application."));
 	mOpenTorrentAction->setToolTip(tr("Opens a dialog where you can choose a torrent to open."));
 	mNewTorrentFromFileAction->setToolTip(tr("Opens a dialog to creates a new torrent from a file."));
 	mNewTorrentFromDirAction->setToolTip(tr("Opens a dialog to creates a new torrent from a directory."));
+	mLanProfileAction->setToolTip(tr("Tunes the connections for a fast local network instead of the internet."));
+	mLanProfileAction->setCheckable(true);
+	mLanProfileAction->setChecked(true);
 
 	// Shutdown the application when the exit action is triggerd.
 	connect(mExitAction, &QAction::triggered,
@@ -136,6 +141,9 @@ void Application::shutdown()
 {
 	shutdownStarted();
 	// TODO Allow modules to delay the process.
+	// Keep the resume data of all torrents for the next start.
+	if (Model *model = this->model())
+		model->session()->close();
 	shutdownFinished();
 	QApplication::quit();
 }
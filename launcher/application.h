@@ -25,6 +25,7 @@ class Application : public QApplication
 	Q_PROPERTY(QAction* openTorrentAction        READ openTorrentAction)
 	Q_PROPERTY(QAction* newTorrentFromFileAction READ newTorrentFromFileAction)
 	Q_PROPERTY(QAction* newTorrentFromDirAction  READ newTorrentFromDirAction)
+	Q_PROPERTY(QAction* lanProfileAction         READ lanProfileAction)
 
 public:
 	explicit Application(int &argc, char **argv);
@@ -36,6 +37,7 @@ public:
 	QAction *openTorrentAction() const        {return mOpenTorrentAction;}
 	QAction *newTorrentFromFileAction() const {return mNewTorrentFromFileAction;}
 	QAction *newTorrentFromDirAction() const  {return mNewTorrentFromDirAction;}
+	QAction *lanProfileAction() const         {return mLanProfileAction;}
 
 	const QIcon &iconDefault() const {return mIconDefault;}
 	const QIcon &iconFailure() const {return mIconFailure;}
@@ -57,6 +59,7 @@ private:
 	QAction *mOpenTorrentAction;
 	QAction *mNewTorrentFromFileAction;
 	QAction *mNewTorrentFromDirAction;
+	QAction *mLanProfileAction;
 
 	const QIcon mIconDefault = QIcon(QStringLiteral(":/icons/app-default"));
 	const QIcon mIconFailure = QIcon(QStringLiteral(":/icons/app-default"));
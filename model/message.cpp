@@ -5,7 +5,7 @@ Message::Message(Level level, QString title, QString message)
 	: QObject()
 	, mLevel(level)
 	, mTitle(title)
-	, mText(text())
+	, mText(message)
 	, mNoticed(false)
 {
 }
@@ -2,6 +2,7 @@
 
 #include "librarymodel.h"
 #include "messagelistmodel.h"
+#include "torrentloader.h"
 #include "torrentsession.h"
 
 
@@ -10,5 +11,6 @@ Model::Model(QObject *parent)
 	, mLibrary(new LibraryModel(this))
 	, mMessages(new MessageListModel(this))
 	, mSession(new TorrentSession(this))
+	, mLoader(new TorrentLoader(mMessages, this))
 {
 }
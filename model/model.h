@@ -5,6 +5,7 @@
 
 class LibraryModel;
 class MessageListModel;
+class TorrentLoader;
 class TorrentSession;
 
 
@@ -14,6 +15,7 @@ class Model : public QObject
 	Q_PROPERTY(LibraryModel*     library  READ library)
 	Q_PROPERTY(MessageListModel* messages READ messages)
 	Q_PROPERTY(TorrentSession*   session  READ session)
+	Q_PROPERTY(TorrentLoader*    loader   READ loader)
 
 public:
 	explicit Model(QObject *parent = 0);
@@ -21,6 +23,7 @@ public:
 	LibraryModel     *library()  {return mLibrary;}
 	MessageListModel *messages() {return mMessages;}
 	TorrentSession   *session()  {return mSession;}
+	TorrentLoader    *loader()   {return mLoader;}
 
 private:
 	Model(const Model &) = delete;
@@ -29,6 +32,7 @@ private:
 	LibraryModel *mLibrary;
 	MessageListModel *mMessages;
 	TorrentSession *mSession;
+	TorrentLoader *mLoader;
 
 };
 
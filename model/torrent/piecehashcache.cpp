@@ -0,0 +1,137 @@
+#include "piecehashcache.h"
+
+#include <algorithm>
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+namespace lt = libtorrent;
+
+// Identifies cache files and their format.
+static const quint32 CACHE_MAGIC = 0x50484331; // "PHC1"
+// Maximum number of entries to save. Entries which were not used since
+// loading are dropped first.
+static const std::size_t MAX_SAVED_ENTRIES = 1 << 20;
+
+
+PieceHashCache::PieceHashCache(const QString &fileName) :
+	mFileName(fileName),
+	mLoaded(false),
+	mHits(0),
+	mMisses(0)
+{
+}
+
+//! Sets the cache file. The entries are loaded again on the next lookup.
+void PieceHashCache::setFileName(const QString &fileName)
+{
+	if (fileName == mFileName)
+		return;
+	mFileName = fileName;
+	mEntries.clear();
+	mLoaded = false;
+}
+
+/**
+ * @brief Loads the entries from the cache file unless already done.
+ *
+ * A missing or invalid cache file leaves the cache empty.
+ *
+ * @return Whether the entries could be loaded.
+ */
+bool PieceHashCache::load()
+{
+	if (mLoaded || !isEnabled())
+		return mLoaded;
+	mLoaded = true;
+
+	QFile file(mFileName);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+	QDataStream stream(&file);
+	quint32 magic;
+	quint32 count;
+	stream >> magic >> count;
+	// Never trust the count of a corrupt file for the allocation.
+	if (stream.status() != QDataStream::Ok || magic != CACHE_MAGIC
+			|| count > MAX_SAVED_ENTRIES)
+		return false;
+
+	mEntries.reserve(count);
+	for (quint32 i = 0; i < count; ++i) {
+		lt::sha1_hash key;
+		Entry entry;
+		if (stream.readRawData(reinterpret_cast<char*>(key.begin()), key.size) != key.size
+				|| stream.readRawData(reinterpret_cast<char*>(entry.hash.begin()),
+				                      entry.hash.size) != entry.hash.size
+				|| stream.status() != QDataStream::Ok) {
+			mEntries.clear();
+			return false;
+		}
+		entry.used = false;
+		mEntries.emplace(key, entry);
+	}
+	return true;
+}
+
+/**
+ * @brief Replaces the cache file atomically with the current entries.
+ *
+ * @return Whether the cache file could be written.
+ */
+bool PieceHashCache::save()
+{
+	if (!isEnabled())
+		return false;
+
+	// Prefer the entries of the recent torrents if there are too many.
+	const std::size_t count = std::min(mEntries.size(), MAX_SAVED_ENTRIES);
+	QSaveFile file(mFileName);
+	if (!file.open(QFile::WriteOnly))
+		return false;
+	QDataStream stream(&file);
+	stream << CACHE_MAGIC << quint32(count);
+	std::size_t written = 0;
+	for (bool used : {true, false}) {
+		for (const auto &entry : mEntries) {
+			if (written == count)
+				break;
+			if (entry.second.used != used)
+				continue;
+			stream.writeRawData(reinterpret_cast<const char*>(entry.first.begin()),
+			                    entry.first.size);
+			stream.writeRawData(reinterpret_cast<const char*>(entry.second.hash.begin()),
+			                    entry.second.hash.size);
+			++written;
+		}
+	}
+	return stream.status() == QDataStream::Ok && file.commit();
+}
+
+/**
+ * @brief Looks up the hash of a piece.
+ *
+ * @param key The key of the piece.
+ * @param hash Receives the hash if found.
+ * @return Whether the hash was found.
+ */
+bool PieceHashCache::find(const lt::sha1_hash &key, lt::sha1_hash &hash)
+{
+	load();
+	const auto it = mEntries.find(key);
+	if (it == mEntries.end()) {
+		++mMisses;
+		return false;
+	}
+	++mHits;
+	it->second.used = true;
+	hash = it->second.hash;
+	return true;
+}
+
+void PieceHashCache::insert(const lt::sha1_hash &key, const lt::sha1_hash &hash)
+{
+	load();
+	mEntries[key] = {hash, true};
+}
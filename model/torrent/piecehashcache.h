@@ -0,0 +1,67 @@
+#ifndef PIECEHASHCACHE_H
+#define PIECEHASHCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include <QString>
+
+#include <libtorrent/peer_id.hpp>
+
+
+/**
+ * @brief Persistent cache of piece hashes.
+ *
+ * A piece is identified by a key which describes where its data comes from:
+ * the path, size and modification time of every file it touches and the
+ * offsets within the files. If none of them changed, the piece hash has not
+ * changed either, so recreating a torrent of a mostly unchanged tree only
+ * needs to hash the modified pieces. Inserting or resizing a file shifts the
+ * pieces behind it, which changes their keys.
+ *
+ * The cache is not thread-safe except for the statistics.
+ */
+class PieceHashCache
+{
+public:
+	explicit PieceHashCache(const QString &fileName = QString());
+
+	QString fileName() const {return mFileName;}
+	void setFileName(const QString &fileName);
+	bool isEnabled() const {return !mFileName.isEmpty();}
+
+	bool load();
+	bool save();
+
+	bool find(const libtorrent::sha1_hash &key, libtorrent::sha1_hash &hash);
+	void insert(const libtorrent::sha1_hash &key, const libtorrent::sha1_hash &hash);
+	std::size_t size() const {return mEntries.size();}
+
+	//! Number of lookups which found a hash.
+	std::uint64_t hits() const {return mHits;}
+	//! Number of lookups which did not find a hash.
+	std::uint64_t misses() const {return mMisses;}
+
+private:
+	struct Entry {
+		libtorrent::sha1_hash hash;
+		bool used; // Looked up or inserted since loading.
+	};
+	// Keys are SHA-1 digests, so their bytes are used as the hash value.
+	struct KeyHash {
+		std::size_t operator()(const libtorrent::sha1_hash &key) const
+		{std::size_t h; std::memcpy(&h, key.begin(), sizeof(h)); return h;}
+	};
+
+	QString mFileName;
+	bool mLoaded;
+	std::unordered_map<libtorrent::sha1_hash, Entry, KeyHash> mEntries;
+	std::atomic<std::uint64_t> mHits;
+	std::atomic<std::uint64_t> mMisses;
+
+};
+
+#endif // PIECEHASHCACHE_H
@@ -2,11 +2,26 @@
 
 #include <libtorrent/torrent_handle.hpp>
 
+#include "torrentdetails.h"
 #include "torrentinfo.h"
 #include "torrentsession.h"
-#include "torrentstatus.h"
+#include "torrentstatusobject.h"
 
 
+/**
+ * @brief Returns a QObject with properties for the status.
+ *
+ * The object is created on the first call. Torrents without such an object
+ * don't emit any signals on status updates.
+ */
+TorrentStatusObject *Torrent::statusObject()
+{
+	if (!mStatusObject) {
+		mStatusObject = new TorrentStatusObject(&mStatus, this);
+	}
+	return mStatusObject;
+}
+
 void Torrent::remove()
 {
 	mSession->removeTorrent(this);
@@ -17,10 +32,25 @@ void Torrent::deleteFiles()
 	mSession->deleteTorrentFiles(this);
 }
 
+/**
+ * @brief Downloads the torrent in the order it is read.
+ *
+ * @see TorrentStreamer
+ */
+void Torrent::setStreaming(bool enabled)
+{
+	mSession->setStreaming(this, enabled);
+}
+
+//! Tells a streamed torrent where its data is read.
+void Torrent::setReadCursor(int fileIndex, qint64 offset)
+{
+	mSession->setReadCursor(this, fileIndex, offset);
+}
+
 Torrent::Torrent(TorrentSession *session) :
 	QObject(session),
-	mSession(session),
-	mStatus(new TorrentStatus(this))
+	mSession(session)
 {
 }
 
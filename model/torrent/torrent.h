@@ -11,27 +11,35 @@
 
 #include <libtorrent/error_code.hpp>
 
+#include "torrentstatus.h"
+
 namespace libtorrent {
 class torrent_handle;
 }
+class TorrentDetails;
 class TorrentInfo;
 class TorrentSession;
-class TorrentStatus;
+class TorrentStatusObject;
 
 
 class Torrent : public QObject
 {
 	Q_OBJECT
-	Q_PROPERTY(const TorrentStatus* status READ status)
+	Q_PROPERTY(TorrentStatusObject* status READ statusObject CONSTANT)
 	Q_PROPERTY(const TorrentInfo* metadata READ metadata NOTIFY metadataReceived)
 	Q_PROPERTY(bool               wasAdded READ wasAdded NOTIFY added)
+	Q_PROPERTY(bool               streaming READ isStreaming WRITE setStreaming)
 
 	friend class TorrentSession;
 
 public:
-	const TorrentStatus *status() const {return mStatus.get();}
+	const TorrentStatus *status() const {return &mStatus;}
+	TorrentStatusObject *statusObject();
 	const TorrentInfo *metadata() const {return mMetadata.get();}
+	//! Returns the details if this is the detailed torrent of the session.
+	const TorrentDetails *details() const {return mDetails.get();}
 	bool wasAdded() const {return mAdded;}
+	bool isStreaming() const {return mStreaming;}
 
 	template<class T>
 	std::shared_ptr<T> &at();
@@ -48,11 +56,13 @@ signals:
 	void deleteFailed(const libtorrent::error_code &error);
 	void metadataReceived();
 	void metadataFailed(const libtorrent::error_code &error);
-	void statusUpdated();
+	void detailsUpdated();
 
 public slots:
 	void remove();
 	void deleteFiles();
+	void setStreaming(bool enabled);
+	void setReadCursor(int fileIndex, qint64 offset);
 
 protected:
 	explicit Torrent(TorrentSession *session);
@@ -63,14 +73,18 @@ private:
 	TorrentSession *mSession;
 	std::unique_ptr<libtorrent::torrent_handle> mHandle;
 
-	std::unique_ptr<TorrentStatus> mStatus;
+	TorrentStatus mStatus;
+	TorrentStatusObject *mStatusObject = nullptr; // Created on demand
+
 	std::unique_ptr<TorrentInfo> mMetadata;
+	std::unique_ptr<TorrentDetails> mDetails;
 
 	std::unordered_map<std::type_index,std::shared_ptr<void*>> mUserdata;
 
 	bool mAdded = false;
 	bool mRemoving = false;
 	bool mDeleting = false;
+	bool mStreaming = false;
 
 };
 
@@ -8,18 +8,49 @@ INCLUDEPATH += $$PWD
 DEPENDPATH  += $$PWD
 
 
-SOURCES += $$PWD/torrent.cpp \
+SOURCES += $$PWD/piecehashcache.cpp \
+    $$PWD/torrent.cpp \
+    $$PWD/torrentdetails.cpp \
+    $$PWD/torrentdisksettings.cpp \
+    $$PWD/torrentengine.cpp \
+    $$PWD/torrentfilereuse.cpp \
+    $$PWD/torrentindex.cpp \
+    $$PWD/torrentloader.cpp \
+    $$PWD/torrentnetworkpolicy.cpp \
+    $$PWD/torrentrefreshpolicy.cpp \
+    $$PWD/torrentresumestore.cpp \
+    $$PWD/torrentalertregistry.cpp \
+    $$PWD/torrentcreator.cpp \
     $$PWD/torrentsession.cpp \
+    $$PWD/torrentsessionprofile.cpp \
     $$PWD/torrentsessionstatus.cpp \
     $$PWD/torrentsmodel.cpp \
     $$PWD/torrentsmodelbase.cpp \
+    $$PWD/torrentstreamer.cpp \
     $$PWD/torrentstatus.cpp \
+    $$PWD/torrentstatusobject.cpp \
     $$PWD/torrentinfo.cpp
 
-HEADERS  += $$PWD/torrent.h \
+HEADERS  += $$PWD/piecehashcache.h \
+    $$PWD/torrent.h \
+    $$PWD/torrentalertregistry.h \
+    $$PWD/torrentcreator.h \
+    $$PWD/torrentdetails.h \
+    $$PWD/torrentdisksettings.h \
+    $$PWD/torrentengine.h \
+    $$PWD/torrentfilereuse.h \
+    $$PWD/torrentindex.h \
+    $$PWD/torrentloader.h \
+    $$PWD/torrentnetworkpolicy.h \
+    $$PWD/torrentrefreshpolicy.h \
+    $$PWD/torrentresumestore.h \
     $$PWD/torrentsession.h \
+    $$PWD/torrentsessionmetrics.h \
+    $$PWD/torrentsessionprofile.h \
     $$PWD/torrentsessionstatus.h \
     $$PWD/torrentsmodel.h \
     $$PWD/torrentsmodelbase.h \
+    $$PWD/torrentstreamer.h \
     $$PWD/torrentstatus.h \
+    $$PWD/torrentstatusobject.h \
     $$PWD/torrentinfo.h
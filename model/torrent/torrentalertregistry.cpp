@@ -0,0 +1,67 @@
+#include "torrentalertregistry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+
+/**
+ * @brief Removes all subscriptions of the given receiver.
+ *
+ * @param receiver The receiver which was passed to
+ *        TorrentAlertRegistry::subscribe.
+ */
+void TorrentAlertRegistry::unsubscribe(const void *receiver)
+{
+	for (Entry &entry : mTable) {
+		auto &subs = entry.subscriptions;
+		subs.erase(std::remove_if(subs.begin(), subs.end(),
+		                          [receiver](const Subscription &sub) {
+		               return sub.receiver == receiver;
+		           }), subs.end());
+	}
+}
+
+//! Returns whether someone is interested in alerts of the given type.
+bool TorrentAlertRegistry::hasSubscribers(int type) const
+{
+	return type >= 0 && type < (int) mTable.size()
+	        && !mTable[type].subscriptions.empty();
+}
+
+//! Returns whether alerts of the given type are derived from torrent_alert.
+//! This is only known for types which have been subscribed once.
+bool TorrentAlertRegistry::isTorrentAlert(int type) const
+{
+	return type >= 0 && type < (int) mTable.size() && mTable[type].torrentAlert;
+}
+
+/**
+ * @brief Passes the alert to all handlers which subscribed to its type.
+ *
+ * Handlers must not subscribe or unsubscribe while they are called.
+ *
+ * @param alert The alert to dispatch.
+ * @param torrent The torrent the alert belongs to or <code>nullptr</code>.
+ */
+void TorrentAlertRegistry::dispatch(const libtorrent::alert &alert,
+			Torrent *torrent) const
+{
+	const int type = alert.type();
+	if (!hasSubscribers(type))
+		return;
+	for (const Subscription &sub : mTable[type].subscriptions) {
+		sub.handler(alert, torrent);
+	}
+}
+
+void TorrentAlertRegistry::add(int type, bool torrentAlert,
+			const void *receiver, Handler handler)
+{
+	assert(type >= 0);
+	if (type >= (int) mTable.size())
+		mTable.resize(type + 1);
+	Entry &entry = mTable[type];
+	entry.torrentAlert = torrentAlert;
+	entry.subscriptions.push_back({receiver, std::move(handler)});
+}
@@ -0,0 +1,67 @@
+#ifndef TORRENTALERTREGISTRY_H
+#define TORRENTALERTREGISTRY_H
+
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include <libtorrent/alert.hpp>
+#include <libtorrent/alert_types.hpp>
+
+class Torrent;
+
+
+/**
+ * @brief Dispatches alerts of libtorrent to the components which subscribed to
+ *        their type.
+ *
+ * The subscriptions are stored in a flat table indexed by the alert type. An
+ * alert is only passed to the handlers which subscribed to its type.
+ */
+class TorrentAlertRegistry
+{
+public:
+	typedef std::function<void(const libtorrent::alert&, Torrent*)> Handler;
+
+	template<class Alert, class Receiver>
+	void subscribe(Receiver *receiver,
+	               void (Receiver::*handler)(const Alert&, Torrent*));
+	void unsubscribe(const void *receiver);
+
+	bool hasSubscribers(int type) const;
+	bool isTorrentAlert(int type) const;
+	void dispatch(const libtorrent::alert &alert, Torrent *torrent) const;
+
+private:
+	struct Subscription {
+		const void *receiver;
+		Handler handler;
+	};
+	struct Entry {
+		bool torrentAlert = false;
+		std::vector<Subscription> subscriptions;
+	};
+
+	void add(int type, bool torrentAlert, const void *receiver, Handler handler);
+
+	std::vector<Entry> mTable;
+
+};
+
+// -----------------------------------------------------------------------------
+
+template<class Alert, class Receiver>
+void TorrentAlertRegistry::subscribe(Receiver *receiver,
+			void (Receiver::*handler)(const Alert&, Torrent*))
+{
+	static_assert(std::is_base_of<libtorrent::alert, Alert>::value,
+	              "Alert must be an alert of libtorrent");
+	add(Alert::alert_type,
+	    std::is_base_of<libtorrent::torrent_alert, Alert>::value,
+	    receiver,
+	    [receiver, handler](const libtorrent::alert &alert, Torrent *torrent) {
+		(receiver->*handler)(static_cast<const Alert&>(alert), torrent);
+	});
+}
+
+#endif // TORRENTALERTREGISTRY_H
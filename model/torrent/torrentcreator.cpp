@@ -0,0 +1,314 @@
+#include "torrentcreator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/hasher.hpp>
+
+namespace lt = libtorrent;
+
+static lt::sha1_hash pieceKey(const lt::file_storage &files,
+                              const std::vector<qint64> &mtimes,
+                              int index, const std::string &basePath);
+
+// Pieces the reader may read ahead of the hashers by default.
+static const int DEFAULT_READ_AHEAD = 16;
+// Files of at least this size start at a piece boundary. Smaller files are
+// packed to avoid wasting most of a piece on padding.
+static const int PAD_FILE_LIMIT = 256 * 1024;
+
+
+namespace {
+
+// State shared between the reader and the hashers.
+struct HashPipeline
+{
+	struct Piece {
+		int index;
+		std::vector<char> data;
+	};
+
+	std::mutex mutex;
+	std::condition_variable pieceAvailable;
+	std::condition_variable spaceAvailable;
+	std::deque<Piece> pieces;
+	std::vector<std::vector<char>> freeBuffers;
+	bool readingDone = false;
+};
+
+}
+
+
+TorrentCreator::TorrentCreator(QObject *parent) :
+	QObject(parent),
+	mRunning(false),
+	mCanceled(false),
+	mThreads(std::max(1u, std::thread::hardware_concurrency())),
+	mReadAhead(DEFAULT_READ_AHEAD)
+{
+}
+
+TorrentCreator::~TorrentCreator()
+{
+	cancel();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+//! Sets the number of hashing threads. Must not be called while running.
+void TorrentCreator::setThreads(int threads)
+{
+	assert(!mRunning);
+	mThreads = std::max(1, threads);
+}
+
+//! Sets how many pieces may be read ahead of the hashers. Must not be called
+//! while running.
+void TorrentCreator::setReadAhead(int pieces)
+{
+	assert(!mRunning);
+	mReadAhead = std::max(1, pieces);
+}
+
+/**
+ * @brief Starts to create a torrent in the background.
+ *
+ * Emits TorrentCreator::finished, TorrentCreator::failed or
+ * TorrentCreator::canceled when done. Must not be called while running.
+ *
+ * @param fileOrDirName The file or directory to share.
+ */
+void TorrentCreator::start(const QString &fileOrDirName)
+{
+	assert(!mRunning);
+	if (mThread.joinable())
+		mThread.join();
+	mRunning = true;
+	mCanceled = false;
+	mFileOrDirName = fileOrDirName;
+	mThread = std::thread(&TorrentCreator::run, this, fileOrDirName);
+}
+
+//! Stops creating the torrent as soon as possible.
+void TorrentCreator::cancel()
+{
+	mCanceled = true;
+}
+
+void TorrentCreator::run(const QString &fileOrDirName)
+{
+	// Walk the tree and plan the pieces.
+	const QFileInfo root(fileOrDirName);
+	const std::string basePath = root.absolutePath().toStdString();
+	lt::file_storage files;
+	lt::add_files(files, root.absoluteFilePath().toStdString());
+	if (files.num_files() == 0 || files.total_size() == 0) {
+		mRunning = false;
+		failed(tr("There are no files in %1.").arg(fileOrDirName));
+		return;
+	}
+	// Align the files to pieces, so the pieces of unchanged files keep their
+	// hashes in later versions and can be reused by TorrentSession::addTorrent.
+	// The torrent adds the pad files to the file storage it was created with.
+	lt::create_torrent torrent(files, 0, PAD_FILE_LIMIT);
+	const int numPieces = torrent.num_pieces();
+	const qint64 totalSize = files.total_size();
+	std::vector<qint64> mtimes;
+	if (mHashCache.isEnabled()) {
+		mtimes.reserve(files.num_files());
+		for (int i = 0; i < files.num_files(); ++i) {
+			if (files.pad_file_at(i)) {
+				mtimes.push_back(0);
+				continue;
+			}
+			const QFileInfo info(QString::fromStdString(files.file_path(i, basePath)));
+			mtimes.push_back(info.lastModified().toMSecsSinceEpoch());
+		}
+	}
+
+	// Report the progress in steps of 0.1 %.
+	std::atomic<qint64> hashedBytes(0);
+	std::atomic<int> reportedPermille(-1);
+	auto reportProgress = [&](qint64 bytes) {
+		const qint64 done = hashedBytes += bytes;
+		const int permille = done * 1000 / totalSize;
+		int last = reportedPermille;
+		while (permille > last) {
+			if (reportedPermille.compare_exchange_weak(last, permille)) {
+				progress(done, totalSize);
+				break;
+			}
+		}
+	};
+
+	// Hash the pieces on the worker pool.
+	HashPipeline pipeline;
+	std::vector<lt::sha1_hash> hashes(numPieces);
+	std::vector<lt::sha1_hash> keys(mHashCache.isEnabled() ? numPieces : 0);
+	std::vector<bool> cached(numPieces, false);
+	std::vector<std::thread> workers;
+	workers.reserve(mThreads);
+	for (int i = 0; i < mThreads; ++i) {
+		workers.emplace_back([&]() {
+			std::unique_lock<std::mutex> lock(pipeline.mutex);
+			for (;;) {
+				pipeline.pieceAvailable.wait(lock, [&]() {
+					return !pipeline.pieces.empty() || pipeline.readingDone;
+				});
+				if (pipeline.pieces.empty())
+					return;
+				HashPipeline::Piece piece = std::move(pipeline.pieces.front());
+				pipeline.pieces.pop_front();
+				lock.unlock();
+
+				if (!mCanceled) {
+					hashes[piece.index] = lt::hasher(piece.data.data(), piece.data.size()).final();
+					reportProgress(piece.data.size());
+				}
+
+				lock.lock();
+				pipeline.freeBuffers.push_back(std::move(piece.data));
+				pipeline.spaceAvailable.notify_one();
+			}
+		});
+	}
+
+	// Read the pieces sequentially. Keep the last file open since pieces are
+	// usually read from the same file again.
+	QString error;
+	QFile file;
+	int openFile = -1;
+	for (int index = 0; index < numPieces && !mCanceled && error.isEmpty(); ++index) {
+		// Skip pieces which have not changed since they were last hashed.
+		if (mHashCache.isEnabled()) {
+			keys[index] = pieceKey(files, mtimes, index, basePath);
+			if (mHashCache.find(keys[index], hashes[index])) {
+				cached[index] = true;
+				reportProgress(torrent.piece_size(index));
+				continue;
+			}
+		}
+
+		// Wait for a free slot in the read-ahead window.
+		std::vector<char> data;
+		{
+			std::unique_lock<std::mutex> lock(pipeline.mutex);
+			pipeline.spaceAvailable.wait(lock, [&]() {
+				return (int) pipeline.pieces.size() < mReadAhead || mCanceled;
+			});
+			if (!pipeline.freeBuffers.empty()) {
+				data = std::move(pipeline.freeBuffers.back());
+				pipeline.freeBuffers.pop_back();
+			}
+		}
+		data.resize(torrent.piece_size(index));
+
+		std::size_t position = 0;
+		for (const lt::file_slice &slice : files.map_block(index, 0, data.size())) {
+			if (files.pad_file_at(slice.file_index)) {
+				std::fill_n(data.begin() + position, slice.size, 0);
+				position += slice.size;
+				continue;
+			}
+			if (slice.file_index != openFile) {
+				file.close();
+				file.setFileName(QString::fromStdString(
+						files.file_path(slice.file_index, basePath)));
+				openFile = slice.file_index;
+				if (!file.open(QFile::ReadOnly)) {
+					error = tr("Could not open %1: %2").arg(file.fileName(), file.errorString());
+					break;
+				}
+			}
+			if (!file.seek(slice.offset)
+					|| file.read(data.data() + position, slice.size) != slice.size) {
+				error = tr("Could not read %1: %2").arg(file.fileName(), file.errorString());
+				break;
+			}
+			position += slice.size;
+		}
+		if (!error.isEmpty())
+			break;
+
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		pipeline.pieces.push_back({index, std::move(data)});
+		pipeline.pieceAvailable.notify_one();
+	}
+	file.close();
+
+	// Let the workers finish the remaining pieces.
+	{
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		pipeline.readingDone = true;
+	}
+	pipeline.pieceAvailable.notify_all();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	if (!error.isEmpty()) {
+		mRunning = false;
+		failed(error);
+		return;
+	}
+	if (mCanceled) {
+		mRunning = false;
+		canceled();
+		return;
+	}
+
+	// Remember the new hashes for the next time.
+	if (mHashCache.isEnabled()) {
+		for (int index = 0; index < numPieces; ++index) {
+			if (!cached[index])
+				mHashCache.insert(keys[index], hashes[index]);
+		}
+		mHashCache.save();
+	}
+
+	// Generate the torrent file.
+	for (int index = 0; index < numPieces; ++index) {
+		torrent.set_hash(index, hashes[index]);
+	}
+	torrent.set_creator("XGME LAN-Client");
+	std::vector<char> data;
+	lt::bencode(std::back_inserter(data), torrent.generate());
+	mRunning = false;
+	finished(QByteArray(data.data(), data.size()));
+}
+
+/**
+ * @brief Returns the key of a piece in the PieceHashCache.
+ *
+ * The key is a digest of the path, size and modification time of every file
+ * the piece touches and of the slices of the files, so it changes whenever
+ * the data of the piece may have changed.
+ */
+static lt::sha1_hash pieceKey(const lt::file_storage &files,
+                              const std::vector<qint64> &mtimes,
+                              int index, const std::string &basePath)
+{
+	lt::hasher hasher;
+	for (const lt::file_slice &slice : files.map_block(index, 0, files.piece_size(index))) {
+		const std::string path = files.file_path(slice.file_index, basePath);
+		const qint64 numbers[] = {files.file_size(slice.file_index),
+		                          mtimes[slice.file_index],
+		                          slice.offset, slice.size};
+		hasher.update(path.c_str(), path.size() + 1);
+		hasher.update(reinterpret_cast<const char*>(numbers), sizeof(numbers));
+	}
+	return hasher.final();
+}
@@ -0,0 +1,69 @@
+#ifndef TORRENTCREATOR_H
+#define TORRENTCREATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+#include "piecehashcache.h"
+
+/**
+ * @brief Creates torrent files from files or directories in the background.
+ *
+ * The creator walks the tree, plans the pieces and hashes them on a pool of
+ * worker threads. A single reader thread reads the pieces sequentially, which
+ * keeps reads friendly to hard disks, and stays at most a few pieces ahead of
+ * the hashers. Pieces whose files have not changed since they were last
+ * hashed are taken from the PieceHashCache without reading them. The signals
+ * are emitted from the background threads, so they
+ * reach receivers in other threads as queued connections.
+ */
+class TorrentCreator : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit TorrentCreator(QObject *parent = 0);
+	virtual ~TorrentCreator();
+
+	bool isRunning() const {return mRunning;}
+	//! The file or directory of the last started torrent.
+	QString fileOrDirName() const {return mFileOrDirName;}
+
+	int threads() const {return mThreads;}
+	void setThreads(int threads);
+	int readAhead() const {return mReadAhead;}
+	void setReadAhead(int pieces);
+	//! Hash cache. Must not be used while running.
+	PieceHashCache *hashCache() {return &mHashCache;}
+	const PieceHashCache *hashCache() const {return &mHashCache;}
+
+signals:
+	void progress(qint64 bytesHashed, qint64 bytesTotal);
+	//! Emitted with the bencoded torrent file.
+	void finished(const QByteArray &torrent);
+	void failed(const QString &error);
+	void canceled();
+
+public slots:
+	void start(const QString &fileOrDirName);
+	void cancel();
+
+private:
+	void run(const QString &fileOrDirName);
+
+	std::thread mThread;
+	QString mFileOrDirName;
+	std::atomic<bool> mRunning;
+	std::atomic<bool> mCanceled;
+	int mThreads;
+	int mReadAhead;
+	PieceHashCache mHashCache;
+
+};
+
+#endif // TORRENTCREATOR_H
@@ -0,0 +1,47 @@
+#include "torrentdetails.h"
+
+#include <libtorrent/peer_info.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+namespace lt = libtorrent;
+
+
+TorrentDetails::TorrentDetails() :
+	mDistributedCopies(-1)
+{
+}
+
+/**
+ * @brief Loads the details from libtorrent.
+ *
+ * @param status Status which was queried with pieces and distributed copies.
+ * @param trackers The trackers of the torrent.
+ * @param peers The peers the torrent is connected to.
+ */
+void TorrentDetails::loadFromLibtorrent(const lt::torrent_status &status,
+			const std::vector<lt::announce_entry> &trackers,
+			const std::vector<lt::peer_info> &peers)
+{
+	mPieces.resize(status.pieces.size());
+	for (int i = 0; i < status.pieces.size(); ++i) {
+		mPieces.setBit(i, status.pieces[i]);
+	}
+	mDistributedCopies = status.distributed_copies;
+
+	mTrackers.clear();
+	mTrackers.reserve(trackers.size());
+	for (const lt::announce_entry &entry : trackers) {
+		mTrackers.append({QString::fromStdString(entry.url), entry.tier,
+		                  entry.verified});
+	}
+
+	mPeers.clear();
+	mPeers.reserve(peers.size());
+	for (const lt::peer_info &peer : peers) {
+		mPeers.append({QString::fromStdString(peer.ip.address().to_string()),
+		               QString::fromStdString(peer.client),
+		               peer.payload_down_speed, peer.payload_up_speed,
+		               peer.progress_ppm});
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef TORRENTDETAILS_H
+#define TORRENTDETAILS_H
+
+#include <vector>
+
+#include <QBitArray>
+#include <QString>
+#include <QVector>
+
+namespace libtorrent {
+struct announce_entry;
+struct peer_info;
+struct torrent_status;
+}
+
+
+/**
+ * @brief Expensive parts of the status of a single torrent.
+ *
+ * These are only fetched for the torrent set by
+ * TorrentSession::setDetailedTorrent. The data is converted in the thread of
+ * the engine.
+ */
+class TorrentDetails
+{
+public:
+	struct Tracker {
+		QString url;
+		int tier;
+		bool verified;
+	};
+	struct Peer {
+		QString address;
+		QString client;
+		int downloadRate;
+		int uploadRate;
+		int progressPPM;
+	};
+
+	TorrentDetails();
+
+	const QBitArray &pieces() const {return mPieces;}
+	float distributedCopies() const {return mDistributedCopies;}
+	const QVector<Tracker> &trackers() const {return mTrackers;}
+	const QVector<Peer> &peers() const {return mPeers;}
+
+	void loadFromLibtorrent(const libtorrent::torrent_status &status,
+	                        const std::vector<libtorrent::announce_entry> &trackers,
+	                        const std::vector<libtorrent::peer_info> &peers);
+
+private:
+	QBitArray mPieces;
+	float mDistributedCopies;
+	QVector<Tracker> mTrackers;
+	QVector<Peer> mPeers;
+
+};
+
+#endif // TORRENTDETAILS_H
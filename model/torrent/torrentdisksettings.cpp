@@ -0,0 +1,111 @@
+#include "torrentdisksettings.h"
+
+#include <algorithm>
+#include <thread>
+
+#include <libtorrent/session.hpp>
+#include <libtorrent/version.hpp>
+#if LIBTORRENT_VERSION_NUM >= 10100
+#include <libtorrent/settings_pack.hpp>
+#else
+#include <libtorrent/session_settings.hpp>
+#endif
+
+namespace lt = libtorrent;
+
+// libtorrent counts the cache in blocks of 16 KiB.
+static const int CACHE_BLOCKS_PER_MIB = 64;
+
+
+//! Returns the settings of the preset.
+TorrentDiskSettings TorrentDiskSettings::fromPreset(Preset preset)
+{
+	// Hashing is limited by the CPU.
+	const int cores = std::max(1u, std::thread::hardware_concurrency());
+	TorrentDiskSettings s;
+	switch (preset) {
+	case HddPreset:
+		// Keep much in the cache and read whole pieces at once, since every
+		// seek costs milliseconds.
+		s.cacheSize = 512;
+		s.cacheExpiry = 300;
+		s.aioThreads = 2;
+		s.hashingThreads = 1;
+		s.filePoolSize = 200;
+		s.readAhead = 64;
+		break;
+	case SsdPreset:
+		s.cacheSize = 256;
+		s.cacheExpiry = 120;
+		s.aioThreads = 8;
+		s.hashingThreads = std::min(cores, 2);
+		s.filePoolSize = 500;
+		s.readAhead = 16;
+		break;
+	case NvmePreset:
+		// The drive answers faster than the cache pays off.
+		s.cacheSize = 128;
+		s.cacheExpiry = 60;
+		s.aioThreads = 16;
+		s.hashingThreads = std::min(cores, 4);
+		s.filePoolSize = 1000;
+		s.readAhead = 8;
+		break;
+	}
+	return s;
+}
+
+/**
+ * @brief Looks up a preset by its name.
+ *
+ * @param name Either "hdd", "ssd" or "nvme", ignoring the case.
+ * @param preset Set to the preset if the name is known.
+ * @return Returns whether the name is known.
+ */
+bool TorrentDiskSettings::presetFromName(const QString &name, Preset &preset)
+{
+	const QString n = name.toLower();
+	if (n == QLatin1String("hdd"))
+		preset = HddPreset;
+	else if (n == QLatin1String("ssd"))
+		preset = SsdPreset;
+	else if (n == QLatin1String("nvme"))
+		preset = NvmePreset;
+	else
+		return false;
+	return true;
+}
+
+//! Applies the settings to a running session.
+void TorrentDiskSettings::apply(lt::session &session) const
+{
+#if LIBTORRENT_VERSION_NUM >= 10100
+	lt::settings_pack pack;
+	if (cacheSize >= 0)
+		pack.set_int(lt::settings_pack::cache_size, cacheSize * CACHE_BLOCKS_PER_MIB);
+	if (cacheExpiry >= 0)
+		pack.set_int(lt::settings_pack::cache_expiry, cacheExpiry);
+	if (aioThreads >= 0)
+		pack.set_int(lt::settings_pack::aio_threads, aioThreads);
+	if (hashingThreads >= 0)
+		pack.set_int(lt::settings_pack::hashing_threads, hashingThreads);
+	if (filePoolSize >= 0)
+		pack.set_int(lt::settings_pack::file_pool_size, filePoolSize);
+	if (readAhead >= 0)
+		pack.set_int(lt::settings_pack::read_cache_line_size, readAhead);
+	session.apply_settings(pack);
+#else
+	lt::session_settings settings = session.settings();
+	if (cacheSize >= 0)
+		settings.cache_size = cacheSize * CACHE_BLOCKS_PER_MIB;
+	if (cacheExpiry >= 0)
+		settings.cache_expiry = cacheExpiry;
+	if (aioThreads >= 0)
+		settings.aio_threads = aioThreads;
+	if (filePoolSize >= 0)
+		settings.file_pool_size = filePoolSize;
+	if (readAhead >= 0)
+		settings.read_cache_line_size = readAhead;
+	session.set_settings(settings);
+#endif
+}
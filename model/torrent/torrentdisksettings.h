@@ -0,0 +1,50 @@
+#ifndef TORRENTDISKSETTINGS_H
+#define TORRENTDISKSETTINGS_H
+
+#include <QString>
+
+namespace libtorrent {
+class session;
+}
+
+
+/**
+ * @brief Tunes how libtorrent reads, writes and hashes data.
+ *
+ * A preset provides values for the kind of storage the torrents are stored
+ * on. Single values can be changed afterwards. Values below 0 keep the
+ * setting of the session, so a default constructed object changes nothing.
+ *
+ * Hashing threads are only supported by libtorrent 1.1 or later.
+ */
+class TorrentDiskSettings
+{
+public:
+	//! Kind of storage the presets are tuned for.
+	enum Preset {
+		HddPreset,  //!< Few threads and large reads to avoid seeking.
+		SsdPreset,  //!< More parallel requests and smaller reads.
+		NvmePreset  //!< Many parallel requests and a small cache.
+	};
+
+	static TorrentDiskSettings fromPreset(Preset preset);
+	static bool presetFromName(const QString &name, Preset &preset);
+
+	void apply(libtorrent::session &session) const;
+
+	//! Size of the disk cache in MiB.
+	int cacheSize = -1;
+	//! Time after which unused blocks are evicted from the cache in s.
+	int cacheExpiry = -1;
+	//! Number of threads which perform disk I/O.
+	int aioThreads = -1;
+	//! Number of threads which hash pieces.
+	int hashingThreads = -1;
+	//! Maximum number of open files.
+	int filePoolSize = -1;
+	//! Number of blocks of 16 KiB which are read ahead into the cache.
+	int readAhead = -1;
+
+};
+
+#endif // TORRENTDISKSETTINGS_H
@@ -0,0 +1,584 @@
+#include "torrentengine.h"
+
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+#include <boost/function.hpp>
+
+#include <QMetaObject>
+#include <QTimer>
+
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/alert.hpp>
+#include <libtorrent/alert_types.hpp>
+#include <libtorrent/bencode.hpp>
+#include <libtorrent/create_torrent.hpp>
+#include <libtorrent/disk_io_thread.hpp>
+#include <libtorrent/ip_filter.hpp>
+#include <libtorrent/peer_info.hpp>
+#include <libtorrent/session.hpp>
+#include <libtorrent/session_settings.hpp>
+#include <libtorrent/session_status.hpp>
+#include <libtorrent/time.hpp>
+#include <libtorrent/torrent_handle.hpp>
+#include <libtorrent/torrent_info.hpp>
+#include <libtorrent/version.hpp>
+
+#include "torrentdetails.h"
+#include "torrentresumestore.h"
+#include "torrentstreamer.h"
+
+namespace lt = libtorrent;
+
+// Interval of the alert timer when alerts are polled.
+static const int ALERT_POLL_INTERVAL = 100;
+// Interval of the alert timer when libtorrent notifies about new alerts. The
+// timer is only a safety net in case a notification gets lost.
+static const int ALERT_FALLBACK_INTERVAL = 1000;
+// Interval in which resume data of changed torrents is saved.
+static const int RESUME_SAVE_INTERVAL = 60 * 1000;
+// Time to wait for the resume data of all torrents when stopping in seconds.
+static const int RESUME_STOP_TIMEOUT = 10;
+// Interval in which the peers of both networks are counted. Fetching the peers
+// of every torrent is too expensive for each status update.
+static const int NETWORK_TRAFFIC_INTERVAL = 5000;
+
+
+TorrentEngine::Event::Event()
+{
+}
+
+TorrentEngine::Event::Event(Event &&other) = default;
+TorrentEngine::Event &TorrentEngine::Event::operator=(Event &&other) = default;
+
+TorrentEngine::Event::~Event()
+{
+}
+
+TorrentEngine::TorrentEngine() :
+	QObject(),
+	mCommandWakeupPending(false),
+	mEventWakeupPending(false),
+	mAlertTicks(0),
+	mIdleAlertTicks(0)
+{
+	// Moves to the thread of the engine together with it.
+	mStreamer = new TorrentStreamer(this);
+}
+
+TorrentEngine::~TorrentEngine()
+{
+	assert(!mSession);
+	for (lt::alert *alert : mPendingAlerts) {
+		delete alert;
+	}
+}
+
+/**
+ * @brief Queues a command which is executed in the thread of the engine.
+ *
+ * Commands are executed in the order they were posted. Commands posted before
+ * TorrentEngine::start or after TorrentEngine::stop are dropped.
+ *
+ * @param command The command to execute.
+ */
+void TorrentEngine::post(Command command)
+{
+	mCommands.push(std::move(command));
+	if (!mCommandWakeupPending.exchange(true)) {
+		QMetaObject::invokeMethod(this, "processCommands", Qt::QueuedConnection);
+	}
+}
+
+/**
+ * @brief Takes the next event which is ready for the GUI thread.
+ *
+ * @param event Receives the event.
+ * @return <code>false</code> if there is no event.
+ */
+bool TorrentEngine::takeEvent(Event &event)
+{
+	return mEvents.pop(event);
+}
+
+/**
+ * @brief Re-enables TorrentEngine::eventsAvailable.
+ *
+ * The signal is only emitted once until the consumer calls this function.
+ * Call it before taking the events.
+ */
+void TorrentEngine::acknowledgeEvents()
+{
+	mEventWakeupPending.store(false);
+}
+
+/**
+ * @brief Changes whether libtorrent hands over alerts itself.
+ *
+ * If enabled, the network thread of libtorrent passes every alert to the engine
+ * which wakes up immediately. Otherwise, the alert queue is polled every
+ * 100 ms. Must be called in the thread of the engine.
+ *
+ * @param enabled Whether libtorrent should hand over alerts.
+ */
+void TorrentEngine::setAlertNotification(bool enabled)
+{
+	mAlertNotification = enabled;
+	if (!mSession)
+		return;
+
+	if (enabled) {
+		mSession->set_alert_dispatch([this](std::auto_ptr<lt::alert> alert) {
+			onAlertDispatched(alert.release());
+		});
+		mAlertTimer->setInterval(ALERT_FALLBACK_INTERVAL);
+	} else {
+		mSession->set_alert_dispatch(
+				boost::function<void(std::auto_ptr<lt::alert>)>());
+		mAlertTimer->setInterval(ALERT_POLL_INTERVAL);
+	}
+}
+
+/**
+ * @brief Applies the policy for peers of the local network and the internet.
+ *
+ * Peers on the local network are never throttled. The limits of the internet
+ * are the rate limits of the session which libtorrent ignores for local
+ * peers. Peers on the internet are blocked by the IP filter.
+ *
+ * Must be called in the thread of the engine.
+ */
+void TorrentEngine::setNetworkPolicy(const TorrentNetworkPolicy &policy)
+{
+	mNetworkPolicy = policy;
+	if (!mSession)
+		return;
+
+	lt::session_settings settings = mSession->settings();
+	settings.ignore_limits_on_local_network = true;
+	settings.local_upload_rate_limit = 0;
+	settings.local_download_rate_limit = 0;
+	settings.upload_rate_limit = policy.wanUploadLimit;
+	settings.download_rate_limit = policy.wanDownloadLimit;
+	mSession->set_settings(settings);
+	mSession->set_ip_filter(policy.wanBlocked ? policy.filter(0, lt::ip_filter::blocked)
+	                                          : lt::ip_filter());
+}
+
+/**
+ * @brief Queues a command which is executed in the background thread.
+ *
+ * Must be called in the thread of the engine, usually by a command. The
+ * background commands are executed in the order they were posted and only
+ * call functions of the session which are thread-safe. They are all finished
+ * before the session is destroyed.
+ *
+ * @param command The command to execute.
+ */
+void TorrentEngine::postBackground(Command command)
+{
+	{
+		std::lock_guard<std::mutex> lock(mBackgroundMutex);
+		mBackgroundCommands.push_back(std::move(command));
+	}
+	mBackgroundPosted.notify_one();
+}
+
+/**
+ * @brief Sets the directory where the resume data is stored.
+ *
+ * Must be called before TorrentEngine::start. Without directory, no resume
+ * data is stored.
+ */
+void TorrentEngine::setResumeDirectory(const QString &directory)
+{
+	assert(!mSession);
+	mResumeStore.reset(new TorrentResumeStore(directory));
+}
+
+//! Number of resume files written or removed since the start.
+std::uint64_t TorrentEngine::resumeWrites() const
+{
+	return mResumeStore ? mResumeStore->writes() : 0;
+}
+
+//! Number of batches the resume files were written in since the start.
+std::uint64_t TorrentEngine::resumeBatches() const
+{
+	return mResumeStore ? mResumeStore->batches() : 0;
+}
+
+/**
+ * @brief Passes the result of a command to the GUI thread.
+ *
+ * Must be called in the thread of the engine, usually by a command.
+ *
+ * @param event The event without alert.
+ */
+void TorrentEngine::postEvent(Event event)
+{
+	mEvents.push(std::move(event));
+	if (!mEventWakeupPending.exchange(true)) {
+		eventsAvailable();
+	}
+}
+
+void TorrentEngine::start()
+{
+	assert(!mSession);
+	mSession.reset(new lt::session(
+			  lt::fingerprint("LC", 1, 0, 0, 0)
+			, std::make_pair(6881, 6891)
+			, "0.0.0.0"
+			, lt::session::start_default_features
+					| lt::session::add_default_plugins
+			, lt::alert::error_notification
+					| lt::alert::peer_notification
+					| lt::alert::port_mapping_notification
+					| lt::alert::storage_notification
+					| lt::alert::tracker_notification
+					| lt::alert::status_notification
+					| lt::alert::ip_block_notification
+					| lt::alert::performance_warning
+					| lt::alert::ip_block_notification
+					| lt::alert::storage_notification
+			TORRENT_LOGPATH_ARG_DEFAULT));
+	mSession->start_lsd();
+	setNetworkPolicy(mNetworkPolicy);
+	mBackgroundStopping = false;
+	mBackgroundThread = std::thread(&TorrentEngine::runBackground, this);
+	// TODO use prioritize partial pieces?
+	// TODO use prefer whole pieces (or another threshold)?
+
+	mAlertTimer = new QTimer(this);
+	connect(mAlertTimer, &QTimer::timeout,
+	        this, &TorrentEngine::processAlerts);
+	mAlertTimer->start(ALERT_POLL_INTERVAL);
+	setAlertNotification(mAlertNotification);
+
+	// Pass the stored torrents to the GUI and keep their resume data up to
+	// date. They are loaded in the background, so the engine adds each batch
+	// and delivers its alerts while the next one is parsed.
+	if (mResumeStore) {
+		postBackground([this](lt::session &) {
+			mResumeStore->load([this](std::vector<lt::add_torrent_params> batch) {
+				{
+					std::lock_guard<std::mutex> lock(mResumedMutex);
+					mResumedBatches.emplace_back(
+							new std::vector<lt::add_torrent_params>(std::move(batch)));
+				}
+				QMetaObject::invokeMethod(this, "postResumedTorrents", Qt::QueuedConnection);
+			});
+		});
+
+		mResumeTimer = new QTimer(this);
+		connect(mResumeTimer, &QTimer::timeout,
+		        this, &TorrentEngine::saveResumeData);
+		mResumeTimer->start(RESUME_SAVE_INTERVAL);
+	}
+}
+
+/**
+ * @brief Saves the resume data of all torrents and destroys the session.
+ *
+ * Does nothing if the engine has been stopped already.
+ */
+void TorrentEngine::stop()
+{
+	// Handle remaining commands to not lose any of them.
+	processCommands();
+	if (mBackgroundThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mBackgroundMutex);
+			mBackgroundStopping = true;
+		}
+		mBackgroundPosted.notify_one();
+		mBackgroundThread.join();
+	}
+	delete mResumeTimer;
+	mResumeTimer = nullptr;
+	if (mSession && mResumeStore)
+		saveAllResumeData();
+	delete mAlertTimer;
+	mAlertTimer = nullptr;
+	mStreamer->stopAll();
+	// Destroying the session blocks until the network thread has stopped.
+	mSession.reset();
+	if (mResumeStore)
+		mResumeStore->flush();
+}
+
+void TorrentEngine::processCommands()
+{
+	mCommandWakeupPending.store(false);
+	Command command;
+	while (mCommands.pop(command)) {
+		if (mSession)
+			command(*mSession);
+	}
+}
+
+void TorrentEngine::processAlerts()
+{
+	if (!mSession)
+		return;
+
+	// Take alerts which were handed over by libtorrent. There may be some even
+	// when polling since the mode may have changed recently.
+	std::deque<lt::alert*> alerts;
+	{
+		std::lock_guard<std::mutex> lock(mAlertMutex);
+		alerts.swap(mPendingAlerts);
+		mAlertWakeupPending = false;
+	}
+	if (!mAlertNotification) {
+		mSession->pop_alerts(&alerts);
+	}
+
+	++mAlertTicks;
+	if (alerts.empty()) {
+		++mIdleAlertTicks;
+		return;
+	}
+
+	// Fetch the data the GUI needs for the alerts and pass them on.
+	for (lt::alert *alert : alerts) {
+		Event event;
+		event.alert.reset(alert);
+		switch (alert->type()) {
+		case lt::state_update_alert::alert_type:
+			event.sessionStatus.reset(new lt::session_status(mSession->status()));
+			trackConnectedTorrents(*alert);
+			if (!mTrafficTimer.isValid() || mTrafficTimer.hasExpired(NETWORK_TRAFFIC_INTERVAL)) {
+				mTrafficTimer.start();
+				event.networkTraffic.reset(new TorrentNetworkTraffic(networkTraffic()));
+			}
+#if LIBTORRENT_VERSION_NUM >= 10100
+			event.cacheStatus.reset(new lt::cache_status());
+			mSession->get_cache_info(event.cacheStatus.get());
+#else
+			event.cacheStatus.reset(new lt::cache_status(mSession->get_cache_status()));
+#endif
+			break;
+		case lt::torrent_finished_alert::alert_type:
+			mStreamer->onFinished(static_cast<lt::torrent_finished_alert*>(alert)->handle);
+			break;
+		case lt::torrent_removed_alert::alert_type:
+			trackConnectedTorrents(*alert);
+			mStreamer->onRemoved(static_cast<lt::torrent_removed_alert*>(alert)->info_hash);
+			break;
+		case lt::metadata_received_alert::alert_type:
+			event.metadata = static_cast<lt::metadata_received_alert*>(alert)
+					->handle.torrent_file();
+			break;
+		}
+		if (mResumeStore)
+			storeResumeData(*alert);
+		mEvents.push(std::move(event));
+	}
+	if (!mEventWakeupPending.exchange(true)) {
+		eventsAvailable();
+	}
+}
+
+/**
+ * @brief Takes an alert from the network thread of libtorrent.
+ *
+ * This function is called by libtorrent in its own thread. It queues the alert
+ * and wakes up the engine if no wakeup is pending yet. Bursts of alerts are
+ * therefore handled with a single call of TorrentEngine::processAlerts.
+ *
+ * @param alert The alert. The engine takes ownership.
+ */
+void TorrentEngine::onAlertDispatched(lt::alert *alert)
+{
+	bool wakeup;
+	{
+		std::lock_guard<std::mutex> lock(mAlertMutex);
+		mPendingAlerts.push_back(alert);
+		wakeup = !mAlertWakeupPending;
+		mAlertWakeupPending = true;
+	}
+	if (wakeup) {
+		QMetaObject::invokeMethod(this, "processAlerts", Qt::QueuedConnection);
+	}
+}
+
+//! Passes the batches of restored torrents to the GUI thread.
+void TorrentEngine::postResumedTorrents()
+{
+	std::deque<std::unique_ptr<std::vector<lt::add_torrent_params>>> batches;
+	{
+		std::lock_guard<std::mutex> lock(mResumedMutex);
+		batches.swap(mResumedBatches);
+	}
+	for (auto &batch : batches) {
+		Event event;
+		event.resumed = std::move(batch);
+		postEvent(std::move(event));
+	}
+}
+
+//! Requests the resume data of all torrents which changed since last time.
+void TorrentEngine::saveResumeData()
+{
+	if (!mSession)
+		return;
+	for (const lt::torrent_handle &handle : mSession->get_torrents()) {
+		try {
+			if (handle.has_metadata() && handle.need_save_resume_data()) {
+				handle.save_resume_data();
+				++mPendingResumeData;
+			}
+		} catch (const lt::libtorrent_exception &) {
+			// The torrent has been removed in the meantime.
+		}
+	}
+}
+
+// Passes the resume data to the store and keeps the store in sync with the
+// torrents of the session.
+void TorrentEngine::storeResumeData(const lt::alert &alert)
+{
+	switch (alert.type()) {
+	case lt::add_torrent_alert::alert_type:
+	case lt::metadata_received_alert::alert_type:
+	{
+		// Store new torrents as soon as they are complete.
+		const lt::torrent_alert &a = static_cast<const lt::torrent_alert&>(alert);
+		if (alert.type() == lt::add_torrent_alert::alert_type
+				&& static_cast<const lt::add_torrent_alert&>(alert).error)
+			break;
+		try {
+			if (a.handle.has_metadata() && !mResumeStore->hasTorrentFile(a.handle.info_hash())) {
+				a.handle.save_resume_data();
+				++mPendingResumeData;
+			}
+		} catch (const lt::libtorrent_exception &) {
+		}
+		break;
+	}
+	case lt::save_resume_data_alert::alert_type:
+	{
+		--mPendingResumeData;
+		const lt::save_resume_data_alert &a =
+				static_cast<const lt::save_resume_data_alert&>(alert);
+		if (!a.resume_data)
+			break;
+		try {
+			const lt::sha1_hash infoHash = a.handle.info_hash();
+			std::vector<char> torrentFile;
+			if (!mResumeStore->hasTorrentFile(infoHash)) {
+				lt::create_torrent torrent(*a.handle.torrent_file());
+				lt::bencode(std::back_inserter(torrentFile), torrent.generate());
+			}
+			std::vector<char> resumeData;
+			lt::bencode(std::back_inserter(resumeData), *a.resume_data);
+			mResumeStore->save(infoHash, std::move(resumeData), std::move(torrentFile));
+		} catch (const lt::libtorrent_exception &) {
+			// The torrent has been removed in the meantime.
+		}
+		break;
+	}
+	case lt::save_resume_data_failed_alert::alert_type:
+		--mPendingResumeData;
+		break;
+	case lt::torrent_removed_alert::alert_type:
+		mResumeStore->remove(static_cast<const lt::torrent_removed_alert&>(alert).info_hash);
+		break;
+	}
+}
+
+// Remembers which torrents have peers, so only their peers are counted.
+void TorrentEngine::trackConnectedTorrents(const lt::alert &alert)
+{
+	switch (alert.type()) {
+	case lt::state_update_alert::alert_type:
+		for (const lt::torrent_status &status
+				: static_cast<const lt::state_update_alert&>(alert).status) {
+			if (status.num_peers > 0)
+				mConnectedTorrents[status.info_hash] = status.handle;
+			else
+				mConnectedTorrents.erase(status.info_hash);
+		}
+		break;
+	case lt::torrent_removed_alert::alert_type:
+		mConnectedTorrents.erase(static_cast<const lt::torrent_removed_alert&>(alert).info_hash);
+		break;
+	}
+}
+
+// Counts the peers and their payload rates of the local network and the
+// internet.
+TorrentNetworkTraffic TorrentEngine::networkTraffic() const
+{
+	TorrentNetworkTraffic traffic;
+	std::vector<lt::peer_info> peers;
+	for (const auto &torrent : mConnectedTorrents) {
+		try {
+			torrent.second.get_peer_info(peers);
+		} catch (const lt::libtorrent_exception &) {
+			// The torrent has been removed in the meantime.
+			continue;
+		}
+		for (const lt::peer_info &peer : peers) {
+			if (mNetworkPolicy.isLocal(peer.ip.address())) {
+				++traffic.lanPeers;
+				traffic.lanDownloadRate += peer.payload_down_speed;
+				traffic.lanUploadRate += peer.payload_up_speed;
+			} else {
+				++traffic.wanPeers;
+				traffic.wanDownloadRate += peer.payload_down_speed;
+				traffic.wanUploadRate += peer.payload_up_speed;
+			}
+		}
+	}
+	return traffic;
+}
+
+// Executes the background commands until the engine stops.
+void TorrentEngine::runBackground()
+{
+	std::unique_lock<std::mutex> lock(mBackgroundMutex);
+	for (;;) {
+		mBackgroundPosted.wait(lock, [this]() {
+			return !mBackgroundCommands.empty() || mBackgroundStopping;
+		});
+		// Finish the queued commands even when stopping.
+		if (mBackgroundCommands.empty())
+			return;
+		Command command = std::move(mBackgroundCommands.front());
+		mBackgroundCommands.pop_front();
+		lock.unlock();
+		command(*mSession);
+		lock.lock();
+	}
+}
+
+// Requests the resume data of all torrents and waits until it has arrived.
+void TorrentEngine::saveAllResumeData()
+{
+	// Stop transfers, so the resume data stays valid, and take the alerts
+	// from the queue of libtorrent directly.
+	mSession->pause();
+	mSession->set_alert_dispatch(boost::function<void(std::auto_ptr<lt::alert>)>());
+	mAlertNotification = false;
+	processAlerts();
+
+	for (const lt::torrent_handle &handle : mSession->get_torrents()) {
+		try {
+			if (handle.has_metadata()) {
+				handle.save_resume_data(lt::torrent_handle::flush_disk_cache);
+				++mPendingResumeData;
+			}
+		} catch (const lt::libtorrent_exception &) {
+		}
+	}
+
+	const lt::ptime deadline = lt::time_now() + lt::seconds(RESUME_STOP_TIMEOUT);
+	while (mPendingResumeData > 0 && lt::time_now() < deadline) {
+		mSession->wait_for_alert(lt::milliseconds(100));
+		processAlerts();
+	}
+}
@@ -0,0 +1,177 @@
+#ifndef TORRENTENGINE_H
+#define TORRENTENGINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/intrusive_ptr.hpp>
+
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <libtorrent/peer_id.hpp>
+#include <libtorrent/torrent_handle.hpp>
+
+#include "spscqueue.h"
+#include "torrentnetworkpolicy.h"
+
+QT_BEGIN_NAMESPACE
+class QString;
+class QTimer;
+QT_END_NAMESPACE
+namespace libtorrent {
+struct add_torrent_params;
+class alert;
+struct cache_status;
+class session;
+struct session_status;
+class torrent_info;
+}
+class TorrentDetails;
+class TorrentResumeStore;
+class TorrentStreamer;
+
+
+/**
+ * @brief Owns the session of libtorrent and runs in its own thread.
+ *
+ * The engine performs every call into libtorrent which might block. The GUI
+ * thread passes commands with TorrentEngine::post and receives alerts with
+ * TorrentEngine::takeEvent. Both directions use lock-free queues. Alerts are
+ * enriched by the results of the blocking calls the GUI would need for them.
+ *
+ * The engine persists the fast resume data of all torrents with a
+ * TorrentResumeStore, periodically for torrents which changed and for all
+ * torrents when it stops. The stored torrents are passed to the GUI thread
+ * when the engine starts, so they can be added without checking their files.
+ *
+ * Commands which would block the engine for long, like preparing files on the
+ * disk, pass their work on with TorrentEngine::postBackground.
+ *
+ * TorrentEngine::post, TorrentEngine::takeEvent and
+ * TorrentEngine::acknowledgeEvents are the only functions which may be called
+ * from another thread.
+ */
+class TorrentEngine : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! An alert together with data which has been fetched for it, or the
+	//! result of a query which was posted as command.
+	struct Event {
+		Event();
+		Event(Event &&other);
+		Event &operator=(Event &&other);
+		~Event();
+
+		std::unique_ptr<libtorrent::alert> alert;
+		//! Status of the session for state_update_alert.
+		std::unique_ptr<libtorrent::session_status> sessionStatus;
+		//! Traffic of the local network and the internet for some of the
+		//! state_update_alert.
+		std::unique_ptr<TorrentNetworkTraffic> networkTraffic;
+		//! Status of the disk cache for state_update_alert.
+		std::unique_ptr<libtorrent::cache_status> cacheStatus;
+		//! Metadata of the torrent for metadata_received_alert.
+		boost::intrusive_ptr<const libtorrent::torrent_info> metadata;
+		//! Details of the torrent with infoHash if there is no alert.
+		std::unique_ptr<TorrentDetails> details;
+		libtorrent::sha1_hash infoHash;
+		//! Torrents restored from resume data which should be added.
+		std::unique_ptr<std::vector<libtorrent::add_torrent_params>> resumed;
+	};
+	typedef std::function<void(libtorrent::session&)> Command;
+
+	TorrentEngine();
+	virtual ~TorrentEngine();
+
+	void post(Command command);
+	bool takeEvent(Event &event);
+	void acknowledgeEvents();
+
+	std::uint64_t alertTicks() const {return mAlertTicks;}
+	std::uint64_t idleAlertTicks() const {return mIdleAlertTicks;}
+
+	void setAlertNotification(bool enabled);
+	void setNetworkPolicy(const TorrentNetworkPolicy &policy);
+	void postEvent(Event event);
+	void postBackground(Command command);
+
+	void setResumeDirectory(const QString &directory);
+	std::uint64_t resumeWrites() const;
+	std::uint64_t resumeBatches() const;
+
+	TorrentStreamer *streamer() const {return mStreamer;}
+
+signals:
+	//! Emitted when events are available after TorrentEngine::acknowledgeEvents
+	//! was called.
+	void eventsAvailable();
+
+public slots:
+	void start();
+	void stop();
+
+private slots:
+	void processCommands();
+	void processAlerts();
+	void saveResumeData();
+	void postResumedTorrents();
+
+private:
+	void onAlertDispatched(libtorrent::alert *alert);
+	void storeResumeData(const libtorrent::alert &alert);
+	void saveAllResumeData();
+	void trackConnectedTorrents(const libtorrent::alert &alert);
+	TorrentNetworkTraffic networkTraffic() const;
+	void runBackground();
+
+	std::unique_ptr<libtorrent::session> mSession;
+	QTimer *mAlertTimer = nullptr;
+	bool mAlertNotification = false;
+	std::unique_ptr<TorrentResumeStore> mResumeStore;
+	QTimer *mResumeTimer = nullptr;
+	// Number of requested resume data which have not arrived yet.
+	int mPendingResumeData = 0;
+	TorrentNetworkPolicy mNetworkPolicy;
+	TorrentStreamer *mStreamer;
+	// Torrents which had peers at their last status update.
+	std::map<libtorrent::sha1_hash, libtorrent::torrent_handle> mConnectedTorrents;
+	// Time since the traffic of the networks has been counted.
+	QElapsedTimer mTrafficTimer;
+
+	// GUI -> engine
+	SpscQueue<Command> mCommands;
+	std::atomic<bool> mCommandWakeupPending;
+	// engine -> GUI
+	SpscQueue<Event> mEvents;
+	std::atomic<bool> mEventWakeupPending;
+	// network thread of libtorrent -> engine
+	std::mutex mAlertMutex;
+	std::deque<libtorrent::alert*> mPendingAlerts;
+	bool mAlertWakeupPending = false;
+	// background thread -> engine
+	std::mutex mResumedMutex;
+	std::deque<std::unique_ptr<std::vector<libtorrent::add_torrent_params>>> mResumedBatches;
+	// engine -> background thread
+	std::thread mBackgroundThread;
+	std::mutex mBackgroundMutex;
+	std::condition_variable mBackgroundPosted;
+	std::deque<Command> mBackgroundCommands;
+	bool mBackgroundStopping = false;
+
+	std::atomic<std::uint64_t> mAlertTicks;
+	std::atomic<std::uint64_t> mIdleAlertTicks;
+
+};
+
+#endif // TORRENTENGINE_H
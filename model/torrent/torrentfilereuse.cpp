@@ -0,0 +1,176 @@
+#include "torrentfilereuse.h"
+
+#include <unordered_map>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#include <libtorrent/file_storage.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+namespace lt = libtorrent;
+
+static bool cloneFile(const QString &from, const QString &to);
+static bool linkFile(const QString &from, const QString &to);
+
+
+/**
+ * @brief Shares the identical files of an older version with a new version.
+ *
+ * Must be called before the new torrent is added, so its check finds them.
+ *
+ * @param target The new version.
+ * @param targetPath The save path of the new version.
+ * @param source The old version.
+ * @param sourcePath The save path of the old version.
+ * @param sourceProgress The verified bytes of every file of the old version
+ *        as returned by libtorrent::torrent_handle::file_progress.
+ * @return The number and total size of the shared files.
+ */
+TorrentFileReuse::Result TorrentFileReuse::reuseFiles(
+			const lt::torrent_info &target, const std::string &targetPath,
+			const lt::torrent_info &source, const std::string &sourcePath,
+			const std::vector<std::int64_t> &sourceProgress)
+{
+	Result result;
+	const lt::file_storage &sourceFiles = source.files();
+	if ((int) sourceProgress.size() != sourceFiles.num_files())
+		return result;
+
+	const lt::file_storage &targetFiles = target.files();
+	const std::vector<int> identical = identicalFiles(target, source);
+	for (int i = 0; i < targetFiles.num_files(); ++i) {
+		const int sourceFile = identical[i];
+		// Incomplete files may still be written by the old version.
+		if (sourceFile < 0 || sourceProgress[sourceFile] != sourceFiles.file_size(sourceFile))
+			continue;
+		if (shareFile(sourceFiles.file_path(sourceFile, sourcePath),
+		              targetFiles.file_path(i, targetPath))) {
+			++result.files;
+			result.bytes += targetFiles.file_size(i);
+		}
+	}
+	return result;
+}
+
+/**
+ * @brief Finds the files of a new version which are identical in an old one.
+ *
+ * @param target The new version.
+ * @param source The old version.
+ * @return The index of the identical file of the old version for every file
+ *         of the new version, or -1 if there is none.
+ */
+std::vector<int> TorrentFileReuse::identicalFiles(const lt::torrent_info &target,
+			const lt::torrent_info &source)
+{
+	const lt::file_storage &targetFiles = target.files();
+	std::vector<int> identical(targetFiles.num_files(), -1);
+	if (target.piece_length() != source.piece_length())
+		return identical;
+
+	const lt::file_storage &sourceFiles = source.files();
+	std::unordered_map<std::string, int> sourceIndex;
+	sourceIndex.reserve(sourceFiles.num_files());
+	for (int i = 0; i < sourceFiles.num_files(); ++i) {
+		if (!sourceFiles.pad_file_at(i))
+			sourceIndex.emplace(sourceFiles.file_path(i), i);
+	}
+	for (int i = 0; i < targetFiles.num_files(); ++i) {
+		if (targetFiles.pad_file_at(i))
+			continue;
+		const auto it = sourceIndex.find(targetFiles.file_path(i));
+		if (it != sourceIndex.end() && isIdentical(target, i, source, it->second))
+			identical[i] = it->second;
+	}
+	return identical;
+}
+
+//! Returns whether the pieces of both files prove that they are identical.
+bool TorrentFileReuse::isIdentical(const lt::torrent_info &target, int targetFile,
+			const lt::torrent_info &source, int sourceFile)
+{
+	const lt::file_storage &targetFiles = target.files();
+	const lt::file_storage &sourceFiles = source.files();
+	const std::int64_t size = targetFiles.file_size(targetFile);
+	const int pieceLength = target.piece_length();
+	if (size == 0 || size != sourceFiles.file_size(sourceFile)
+			|| pieceLength != source.piece_length()
+			|| targetFiles.file_offset(targetFile) % pieceLength != 0
+			|| sourceFiles.file_offset(sourceFile) % pieceLength != 0) {
+		return false;
+	}
+
+	// The last piece may contain data of the next file. Equal hashes prove
+	// that this data is equal, too.
+	const int targetPiece = targetFiles.file_offset(targetFile) / pieceLength;
+	const int sourcePiece = sourceFiles.file_offset(sourceFile) / pieceLength;
+	const int pieces = (size + pieceLength - 1) / pieceLength;
+	for (int i = 0; i < pieces; ++i) {
+		if (target.hash_for_piece(targetPiece + i) != source.hash_for_piece(sourcePiece + i))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Makes a file available at a second path without copying its data.
+ *
+ * @param from The existing file.
+ * @param to The new path. Nothing happens if it exists already.
+ * @return Whether the file was cloned or linked.
+ */
+bool TorrentFileReuse::shareFile(const std::string &from, const std::string &to)
+{
+	const QString fromName = QString::fromLocal8Bit(from.c_str());
+	const QString toName = QString::fromLocal8Bit(to.c_str());
+	if (QFileInfo::exists(toName) || !QFileInfo(fromName).isFile())
+		return false;
+	if (!QDir().mkpath(QFileInfo(toName).absolutePath()))
+		return false;
+	return cloneFile(fromName, toName) || linkFile(fromName, toName);
+}
+
+
+// Clones a file copy-on-write if the file system supports it.
+static bool cloneFile(const QString &from, const QString &to)
+{
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+	QFile source(from);
+	QFile target(to);
+	if (!source.open(QFile::ReadOnly) || !target.open(QFile::WriteOnly))
+		return false;
+	if (ioctl(target.handle(), FICLONE, source.handle()) == 0)
+		return true;
+	target.remove();
+	return false;
+#else
+	Q_UNUSED(from);
+	Q_UNUSED(to);
+	return false;
+#endif
+}
+
+// Creates a hardlink if both paths are on the same file system.
+static bool linkFile(const QString &from, const QString &to)
+{
+#if defined(Q_OS_WIN)
+	return CreateHardLinkW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(to).utf16()),
+	                       reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(from).utf16()),
+	                       nullptr);
+#else
+	return link(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
@@ -0,0 +1,54 @@
+#ifndef TORRENTFILEREUSE_H
+#define TORRENTFILEREUSE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace libtorrent {
+class torrent_info;
+}
+
+
+/**
+ * @brief Seeds the files of a new torrent version from an older version.
+ *
+ * Torrents are considered versions of each other if their names are equal.
+ * The name is only a hint, the files themselves are compared by their hashes.
+ *
+ * A file is known to be identical in both versions if it has the same path
+ * and size, starts at a piece boundary in both torrents and all pieces which
+ * cover it have the same hashes. Torrents created by TorrentCreator align
+ * larger files to pieces with pad files, so only the changed files differ.
+ *
+ * Identical files are cloned copy-on-write where the file system supports it
+ * and hardlinked otherwise. Existing files of the new version are never
+ * touched. Only files which the old version has completely downloaded and
+ * verified are shared, so libtorrent never writes to them.
+ */
+class TorrentFileReuse
+{
+public:
+	//! Result of TorrentFileReuse::reuseFiles.
+	struct Result {
+		int files = 0;
+		std::int64_t bytes = 0;
+	};
+
+	static Result reuseFiles(const libtorrent::torrent_info &target,
+	                         const std::string &targetPath,
+	                         const libtorrent::torrent_info &source,
+	                         const std::string &sourcePath,
+	                         const std::vector<std::int64_t> &sourceProgress);
+	static std::vector<int> identicalFiles(const libtorrent::torrent_info &target,
+	                                       const libtorrent::torrent_info &source);
+	static bool isIdentical(const libtorrent::torrent_info &target, int targetFile,
+	                        const libtorrent::torrent_info &source, int sourceFile);
+	static bool shareFile(const std::string &from, const std::string &to);
+
+private:
+	TorrentFileReuse() = delete;
+
+};
+
+#endif // TORRENTFILEREUSE_H
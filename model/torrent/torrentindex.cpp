@@ -0,0 +1,175 @@
+#include "torrentindex.h"
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include "torrent.h"
+
+namespace lt = libtorrent;
+
+// Initial number of slots of a shard.
+static const std::size_t INITIAL_SLOTS = 8;
+
+
+void TorrentIndex::const_iterator::skipEmpty()
+{
+	while (mShard != mEnd) {
+		const std::size_t slots = mShard->slots.size();
+		while (mSlot < slots && !mShard->slots[mSlot].torrent) {
+			++mSlot;
+		}
+		if (mSlot < slots)
+			return;
+		++mShard;
+		mSlot = 0;
+	}
+}
+
+TorrentIndex::TorrentIndex() :
+	mSize(0)
+{
+}
+
+TorrentIndex::~TorrentIndex()
+{
+}
+
+/**
+ * @brief Looks up a torrent.
+ * @param infoHash The info hash of the torrent.
+ * @return The torrent or <code>nullptr</code> if there is none.
+ */
+Torrent *TorrentIndex::find(const lt::sha1_hash &infoHash) const
+{
+	const Shard &shard = shardOf(infoHash);
+	if (shard.slots.empty())
+		return nullptr;
+	return shard.slots[findSlot(shard, infoHash)].torrent.get();
+}
+
+/**
+ * @brief Inserts a torrent unless there is one with the same info hash.
+ * @param infoHash The info hash of the torrent.
+ * @param torrent The torrent to insert.
+ * @return The torrent in the index, which is the existing one if there was
+ *         already one with this info hash.
+ */
+Torrent *TorrentIndex::insert(const lt::sha1_hash &infoHash,
+			std::unique_ptr<Torrent> torrent)
+{
+	assert(torrent);
+	Shard &shard = shardOf(infoHash);
+	// Keep the load factor below 3/4.
+	if ((shard.size + 1) * 4 > shard.slots.size() * 3) {
+		grow(shard);
+	}
+
+	Slot &slot = shard.slots[findSlot(shard, infoHash)];
+	if (!slot.torrent) {
+		slot.infoHash = infoHash;
+		slot.torrent = std::move(torrent);
+		++shard.size;
+		++mSize;
+	}
+	return slot.torrent.get();
+}
+
+/**
+ * @brief Removes a torrent from the index and passes it to the caller.
+ * @param infoHash The info hash of the torrent.
+ * @return The torrent or an empty pointer if there is none.
+ */
+std::unique_ptr<Torrent> TorrentIndex::take(const lt::sha1_hash &infoHash)
+{
+	Shard &shard = shardOf(infoHash);
+	if (shard.slots.empty())
+		return std::unique_ptr<Torrent>();
+	std::size_t i = findSlot(shard, infoHash);
+	std::unique_ptr<Torrent> torrent = std::move(shard.slots[i].torrent);
+	if (!torrent)
+		return torrent;
+	--shard.size;
+	--mSize;
+
+	// Shift following entries back which would not be found anymore otherwise.
+	const std::size_t mask = shard.slots.size() - 1;
+	std::size_t j = i;
+	for (;;) {
+		j = (j + 1) & mask;
+		Slot &next = shard.slots[j];
+		if (!next.torrent)
+			break;
+		const std::size_t home = slotHash(next.infoHash) & mask;
+		// Move the entry if its home slot is not between the hole and itself.
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			shard.slots[i].infoHash = next.infoHash;
+			shard.slots[i].torrent = std::move(next.torrent);
+			i = j;
+		}
+	}
+	return torrent;
+}
+
+/**
+ * @brief Removes and destroys a torrent.
+ * @param infoHash The info hash of the torrent.
+ * @return <code>false</code> if there was no such torrent.
+ */
+bool TorrentIndex::erase(const lt::sha1_hash &infoHash)
+{
+	return take(infoHash) != nullptr;
+}
+
+//! Removes and destroys all torrents.
+void TorrentIndex::clear()
+{
+	for (Shard &shard : mShards) {
+		shard.slots.clear();
+		shard.size = 0;
+	}
+	mSize = 0;
+}
+
+std::size_t TorrentIndex::slotHash(const lt::sha1_hash &infoHash)
+{
+	// The first byte selects the shard, so use the following ones.
+	std::size_t hash;
+	std::memcpy(&hash, infoHash.begin() + 1, sizeof(hash));
+	return hash;
+}
+
+TorrentIndex::Shard &TorrentIndex::shardOf(const lt::sha1_hash &infoHash)
+{
+	return mShards[*infoHash.begin() >> (8 - SHARD_BITS)];
+}
+
+const TorrentIndex::Shard &TorrentIndex::shardOf(const lt::sha1_hash &infoHash) const
+{
+	return mShards[*infoHash.begin() >> (8 - SHARD_BITS)];
+}
+
+// Returns the slot with the info hash or the empty slot where it would be.
+std::size_t TorrentIndex::findSlot(const Shard &shard, const lt::sha1_hash &infoHash)
+{
+	const std::size_t mask = shard.slots.size() - 1;
+	std::size_t i = slotHash(infoHash) & mask;
+	while (shard.slots[i].torrent && shard.slots[i].infoHash != infoHash) {
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+void TorrentIndex::grow(Shard &shard)
+{
+	std::vector<Slot> old;
+	old.swap(shard.slots);
+	shard.slots.resize(old.empty() ? INITIAL_SLOTS : old.size() * 2);
+	for (Slot &slot : old) {
+		if (slot.torrent) {
+			Slot &target = shard.slots[findSlot(shard, slot.infoHash)];
+			target.infoHash = slot.infoHash;
+			target.torrent = std::move(slot.torrent);
+		}
+	}
+}
@@ -0,0 +1,101 @@
+#ifndef TORRENTINDEX_H
+#define TORRENTINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <libtorrent/peer_id.hpp>
+
+class Torrent;
+
+
+/**
+ * @brief Hash index of torrents by info hash.
+ *
+ * The index owns the torrents. It is split into shards by the first byte of
+ * the info hash. Every shard is a flat table with open addressing and linear
+ * probing, which keeps a lookup within one or two cache lines. Info hashes
+ * are SHA-1 digests, so their bytes are used as the hash value directly.
+ *
+ * Removing uses backward shift deletion, so there are no tombstones and
+ * lookups of missing keys stop at the first empty slot.
+ */
+class TorrentIndex
+{
+	struct Slot {
+		libtorrent::sha1_hash infoHash;
+		std::unique_ptr<Torrent> torrent; // Empty slots have no torrent.
+	};
+	struct Shard {
+		std::vector<Slot> slots; // Size is zero or a power of two.
+		std::size_t size = 0;
+	};
+
+public:
+	//! Iterates over all torrents in an undefined order.
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Torrent *value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Torrent *const *pointer;
+		typedef Torrent *reference;
+
+		Torrent *operator*() const {return mShard->slots[mSlot].torrent.get();}
+		const_iterator &operator++() {++mSlot; skipEmpty(); return *this;}
+		bool operator==(const const_iterator &other) const
+		{return mShard == other.mShard && mSlot == other.mSlot;}
+		bool operator!=(const const_iterator &other) const
+		{return !(*this == other);}
+
+	private:
+		friend class TorrentIndex;
+		const_iterator(const Shard *shard, const Shard *end) :
+			mShard(shard), mEnd(end), mSlot(0) {skipEmpty();}
+		void skipEmpty();
+
+		const Shard *mShard;
+		const Shard *mEnd;
+		std::size_t mSlot;
+	};
+
+	TorrentIndex();
+	~TorrentIndex();
+
+	Torrent *find(const libtorrent::sha1_hash &infoHash) const;
+	Torrent *insert(const libtorrent::sha1_hash &infoHash,
+	                std::unique_ptr<Torrent> torrent);
+	std::unique_ptr<Torrent> take(const libtorrent::sha1_hash &infoHash);
+	bool erase(const libtorrent::sha1_hash &infoHash);
+	void clear();
+
+	std::size_t size() const {return mSize;}
+	bool empty() const {return mSize == 0;}
+
+	const_iterator begin() const {return const_iterator(mShards, mShards + SHARDS);}
+	const_iterator end() const {return const_iterator(mShards + SHARDS, mShards + SHARDS);}
+
+private:
+	TorrentIndex(const TorrentIndex &) = delete;
+	TorrentIndex &operator=(const TorrentIndex &) = delete;
+
+	static const int SHARD_BITS = 4;
+	static const int SHARDS = 1 << SHARD_BITS;
+
+	static std::size_t slotHash(const libtorrent::sha1_hash &infoHash);
+	Shard &shardOf(const libtorrent::sha1_hash &infoHash);
+	const Shard &shardOf(const libtorrent::sha1_hash &infoHash) const;
+	static std::size_t findSlot(const Shard &shard,
+	                            const libtorrent::sha1_hash &infoHash);
+	static void grow(Shard &shard);
+
+	Shard mShards[SHARDS];
+	std::size_t mSize;
+
+};
+
+#endif // TORRENTINDEX_H
@@ -1,13 +1,19 @@
 #include "torrentinfo.h"
 
+#include <utility>
+
+#include <libtorrent/file_storage.hpp>
 #include <libtorrent/torrent_info.hpp>
 
 namespace lt = libtorrent;
 
+static QString decode(const std::string &string);
+
 
-TorrentInfo::TorrentInfo(const libtorrent::torrent_info &data, QObject *parent) :
+TorrentInfo::TorrentInfo(boost::intrusive_ptr<const lt::torrent_info> data,
+			QObject *parent) :
 	QObject(parent),
-	mData(new lt::torrent_info(data))
+	mData(std::move(data))
 {
 }
 
@@ -15,17 +21,82 @@ TorrentInfo::~TorrentInfo()
 {
 }
 
-const QString TorrentInfo::name() const
+//! Returns the libtorrent metadata. It must not be modified.
+boost::intrusive_ptr<const lt::torrent_info> TorrentInfo::data() const
+{
+	return mData;
+}
+
+/**
+ * @brief Estimates the memory used by the metadata in bytes.
+ *
+ * Counts the info section, which libtorrent keeps as a whole, and the file
+ * entries. The piece hashes point into the info section. This is what every
+ * copy of the metadata would cost.
+ */
+std::size_t TorrentInfo::memoryUsage() const
+{
+	return sizeof(lt::torrent_info)
+			+ mData->metadata_size()
+			+ mData->files().num_files() * sizeof(lt::internal_file_entry);
+}
+
+const QString &TorrentInfo::name() const
+{
+	if (mName.isNull())
+		mName = decode(mData->name());
+	return mName;
+}
+
+const QString &TorrentInfo::comment() const
+{
+	if (mComment.isNull())
+		mComment = decode(mData->comment());
+	return mComment;
+}
+
+const QString &TorrentInfo::creator() const
+{
+	if (mCreator.isNull())
+		mCreator = decode(mData->creator());
+	return mCreator;
+}
+
+//! Returns the number of files including pad files.
+int TorrentInfo::fileCount() const
+{
+	return mData->num_files();
+}
+
+//! Returns the path of the file relative to the save path.
+const QString &TorrentInfo::filePath(int index) const
+{
+	if (mFilePaths.isEmpty())
+		mFilePaths.resize(fileCount());
+	QString &path = mFilePaths[index];
+	if (path.isNull())
+		path = decode(mData->files().file_path(index));
+	return path;
+}
+
+qint64 TorrentInfo::fileSize(int index) const
 {
-	return QString::fromLocal8Bit(mData->name().c_str());
+	return mData->files().file_size(index);
 }
 
-const QString TorrentInfo::comment() const
+//! Returns whether the file only aligns the next file to a piece.
+bool TorrentInfo::isPadFile(int index) const
 {
-	return QString::fromLocal8Bit(mData->comment().c_str());
+	return mData->files().pad_file_at(index);
 }
 
-const QString TorrentInfo::creator() const
+
+// Decodes a string of the metadata. The strings are UTF-8 encoded. Returns an
+// empty but not null string for empty input, so it is not decoded again.
+static QString decode(const std::string &string)
 {
-	return QString::fromLocal8Bit(mData->creator().c_str());
+	QString result = QString::fromUtf8(string.data(), string.size());
+	if (result.isNull())
+		result = QStringLiteral("");
+	return result;
 }
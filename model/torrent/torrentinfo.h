@@ -1,16 +1,31 @@
 #ifndef TORRENTINFO_H
 #define TORRENTINFO_H
 
+#include <cstddef>
+
 #include <boost/intrusive_ptr.hpp>
 
 #include <QObject>
 #include <QString>
+#include <QVector>
 
 namespace libtorrent {
 class torrent_info;
 }
 
 
+/**
+ * @brief Read-only view on the metadata of a torrent.
+ *
+ * The metadata is shared with libtorrent and never copied. The session never
+ * modifies it after the torrent has been added, but libtorrent itself may,
+ * e.g. when trackers are edited or files are renamed.
+ *
+ * Strings are decoded from UTF-8 when they are first accessed and cached
+ * afterwards, so views can query them on every repaint. The paths of the
+ * files are decoded one by one when needed, which keeps torrents with many
+ * files cheap until their file list is actually shown.
+ */
 class TorrentInfo : public QObject
 {
 	Q_OBJECT
@@ -19,15 +34,30 @@ class TorrentInfo : public QObject
 	Q_PROPERTY(QString creator READ creator)
 
 public:
-	explicit TorrentInfo(const libtorrent::torrent_info &data, QObject *parent = 0);
+	explicit TorrentInfo(boost::intrusive_ptr<const libtorrent::torrent_info> data,
+	                     QObject *parent = 0);
 	virtual ~TorrentInfo();
 
-	const QString name() const;
-	const QString comment() const;
-	const QString creator() const;
+	const QString &name() const;
+	const QString &comment() const;
+	const QString &creator() const;
+
+	int fileCount() const;
+	const QString &filePath(int index) const;
+	qint64 fileSize(int index) const;
+	bool isPadFile(int index) const;
+
+	boost::intrusive_ptr<const libtorrent::torrent_info> data() const;
+	std::size_t memoryUsage() const;
 
 private:
-	boost::intrusive_ptr<libtorrent::torrent_info> mData;
+	boost::intrusive_ptr<const libtorrent::torrent_info> mData;
+
+	// Decoded on first access.
+	mutable QString mName;
+	mutable QString mComment;
+	mutable QString mCreator;
+	mutable QVector<QString> mFilePaths;
 
 };
 
@@ -0,0 +1,171 @@
+#include "torrentloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include <QFile>
+#include <QMetaObject>
+
+#include <libtorrent/error_code.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+#include "message.h"
+#include "messagelistmodel.h"
+
+namespace lt = libtorrent;
+
+// Torrent files larger than this are rejected without reading them.
+static const qint64 MAX_TORRENT_FILE_SIZE = 64 * 1024 * 1024;
+
+
+TorrentLoader::TorrentLoader(MessageListModel *messages, QObject *parent) :
+	QObject(parent),
+	mMessages(messages)
+{
+}
+
+TorrentLoader::~TorrentLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+		mJobs.clear();
+	}
+	mJobAvailable.notify_all();
+	for (std::thread &thread : mThreads) {
+		thread.join();
+	}
+}
+
+/**
+ * @brief Queues a torrent file to be parsed.
+ *
+ * Emits TorrentLoader::loaded or TorrentLoader::failed later.
+ *
+ * @param fileName The torrent file.
+ */
+void TorrentLoader::load(const QString &fileName)
+{
+	loadAll(QStringList(fileName));
+}
+
+//! Queues multiple torrent files to be parsed.
+void TorrentLoader::loadAll(const QStringList &fileNames)
+{
+	if (fileNames.isEmpty())
+		return;
+	if (mPending == 0)
+		mBusyTimer.start();
+	mPending += fileNames.size();
+
+	// Start the workers on first use.
+	if (mThreads.empty()) {
+		const unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int i = 0; i < threads; ++i) {
+			mThreads.emplace_back(&TorrentLoader::run, this);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.insert(mJobs.end(), fileNames.begin(), fileNames.end());
+	}
+	mJobAvailable.notify_all();
+}
+
+// Passes the results of the workers on. Called once for all results which
+// arrived until the event loop runs again.
+void TorrentLoader::deliverResults()
+{
+	std::vector<Result> results;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		results.swap(mResults);
+		mDeliveryPending = false;
+	}
+
+	for (const Result &result : results) {
+		--mPending;
+		++mStats.files;
+		mStats.bytes += result.size;
+		mStats.parseTime += result.parseTime;
+		mStats.maxParseTime = std::max(mStats.maxParseTime, result.parseTime);
+		if (result.info) {
+			loaded(result.fileName, result.info);
+		} else {
+			++mStats.failedFiles;
+			mMessages->addMessage(new Message(
+					Message::Failure, tr("Could not open torrent"),
+					tr("Could not open %1: %2").arg(result.fileName, result.error)));
+			failed(result.fileName, result.error);
+		}
+	}
+	if (mPending == 0) {
+		mStats.busyTime += mBusyTimer.nsecsElapsed() / 1000;
+		finished();
+	}
+}
+
+void TorrentLoader::run()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;) {
+		mJobAvailable.wait(lock, [this]() {return !mJobs.empty() || mStopping;});
+		if (mStopping)
+			return;
+		const QString fileName = std::move(mJobs.front());
+		mJobs.pop_front();
+		lock.unlock();
+
+		Result result = parse(fileName);
+
+		lock.lock();
+		mResults.push_back(std::move(result));
+		if (!mDeliveryPending) {
+			mDeliveryPending = true;
+			QMetaObject::invokeMethod(this, "deliverResults", Qt::QueuedConnection);
+		}
+	}
+}
+
+// Parses a torrent file. Runs in a worker thread.
+TorrentLoader::Result TorrentLoader::parse(const QString &fileName)
+{
+	const auto start = std::chrono::steady_clock::now();
+	Result result;
+	result.fileName = fileName;
+
+	QFile file(fileName);
+	if (!file.open(QFile::ReadOnly)) {
+		result.error = file.errorString();
+		return result;
+	}
+	const qint64 size = file.size();
+	result.size = size;
+	if (size == 0 || size > MAX_TORRENT_FILE_SIZE) {
+		result.error = tr("The file is empty or too large.");
+		return result;
+	}
+
+	// Map the file instead of copying it. libtorrent keeps its own copy of the
+	// parts it needs, so the mapping is released right away.
+	QByteArray buffer;
+	const char *data = reinterpret_cast<const char*>(file.map(0, size));
+	if (!data) {
+		buffer = file.readAll();
+		data = buffer.constData();
+	}
+	lt::error_code error;
+	boost::intrusive_ptr<lt::torrent_info> info(new lt::torrent_info(data, size, error));
+	if (buffer.isNull())
+		file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+	if (error)
+		result.error = QString::fromStdString(error.message());
+	else
+		result.info = std::move(info);
+
+	result.parseTime = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - start).count();
+	return result;
+}
@@ -0,0 +1,111 @@
+#ifndef TORRENTLOADER_H
+#define TORRENTLOADER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/intrusive_ptr.hpp>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+namespace libtorrent {
+class torrent_info;
+}
+class MessageListModel;
+
+
+/**
+ * @brief Parses torrent files in the background.
+ *
+ * Every file is memory-mapped and decoded on a pool of worker threads, so
+ * opening many torrent files at once does not block the GUI. The results are
+ * collected and delivered in the thread of the loader. Files which cannot be
+ * parsed are reported to the MessageListModel.
+ */
+class TorrentLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! Counters about the parsed files.
+	struct Stats {
+		std::uint64_t files = 0;
+		std::uint64_t failedFiles = 0;
+		//! Size of all parsed files in bytes.
+		std::uint64_t bytes = 0;
+		//! Sum of the time spent parsing single files in µs.
+		std::uint64_t parseTime = 0;
+		//! Longest time spent parsing a single file in µs.
+		std::uint64_t maxParseTime = 0;
+		//! Time in which files were waiting or being parsed in µs.
+		std::uint64_t busyTime = 0;
+
+		//! Average time to parse a file in µs.
+		double averageParseTime() const
+		{
+			return files ? (double) parseTime / files : 0.0;
+		}
+		//! Parsed bytes per second of busy time.
+		double throughput() const
+		{
+			return busyTime ? bytes * 1e6 / busyTime : 0.0;
+		}
+	};
+
+	explicit TorrentLoader(MessageListModel *messages, QObject *parent = 0);
+	virtual ~TorrentLoader();
+
+	const Stats &stats() const {return mStats;}
+	//! Number of files which have not been delivered yet.
+	int pending() const {return mPending;}
+
+signals:
+	void loaded(const QString &fileName,
+	            boost::intrusive_ptr<libtorrent::torrent_info> info);
+	void failed(const QString &fileName, const QString &error);
+	//! Emitted after the results of all queued files have been delivered.
+	void finished();
+
+public slots:
+	void load(const QString &fileName);
+	void loadAll(const QStringList &fileNames);
+
+private slots:
+	void deliverResults();
+
+private:
+	struct Result {
+		QString fileName;
+		boost::intrusive_ptr<libtorrent::torrent_info> info;
+		QString error;
+		std::uint64_t size = 0;
+		std::uint64_t parseTime = 0;
+	};
+
+	void run();
+	static Result parse(const QString &fileName);
+
+	MessageListModel *mMessages;
+
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mJobAvailable;
+	std::deque<QString> mJobs;
+	std::vector<Result> mResults;
+	bool mDeliveryPending = false;
+	bool mStopping = false;
+
+	int mPending = 0;
+	Stats mStats;
+	QElapsedTimer mBusyTimer;
+
+};
+
+#endif // TORRENTLOADER_H
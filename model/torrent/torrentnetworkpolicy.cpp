@@ -0,0 +1,126 @@
+#include "torrentnetworkpolicy.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <libtorrent/error_code.hpp>
+#include <libtorrent/ip_filter.hpp>
+
+namespace lt = libtorrent;
+
+template<class Bytes>
+static Bytes maskBytes(Bytes bytes, int prefix, bool last);
+static lt::address maskAddress(const lt::address &address, int prefix, bool last);
+static lt::address unmapped(const lt::address &address);
+
+
+//! Creates a policy which treats private, link-local and loopback networks as
+//! local and does not limit the internet.
+TorrentNetworkPolicy::TorrentNetworkPolicy()
+{
+	addSubnet("10.0.0.0", 8);
+	addSubnet("172.16.0.0", 12);
+	addSubnet("192.168.0.0", 16);
+	addSubnet("169.254.0.0", 16);
+	addSubnet("127.0.0.0", 8);
+	addSubnet("fc00::", 7);
+	addSubnet("fe80::", 10);
+	addSubnet("::1", 128);
+}
+
+/**
+ * @brief Adds a subnet to the local network.
+ *
+ * @param subnet The subnet in CIDR notation, e.g. <code>198.51.100.0/24</code>.
+ *        A single address is a subnet of its own.
+ * @return Returns whether the subnet was valid.
+ */
+bool TorrentNetworkPolicy::addSubnet(const std::string &subnet)
+{
+	const std::string::size_type slash = subnet.find('/');
+	const std::string address = subnet.substr(0, slash);
+	int prefix = -1;
+	if (slash != std::string::npos) {
+		const std::string prefixStr = subnet.substr(slash + 1);
+		char *end = nullptr;
+		prefix = std::strtol(prefixStr.c_str(), &end, 10);
+		if (prefixStr.empty() || *end != '\0' || prefix < 0)
+			return false;
+	}
+	return addSubnet(address.c_str(), prefix);
+}
+
+//! Returns whether the address belongs to the local network.
+bool TorrentNetworkPolicy::isLocal(const lt::address &address) const
+{
+	const lt::address a = unmapped(address);
+	return std::any_of(mSubnets.begin(), mSubnets.end(), [&a](const Subnet &s) {
+		return s.address.is_v4() == a.is_v4()
+				&& maskAddress(a, s.prefix, false) == s.address;
+	});
+}
+
+/**
+ * @brief Returns an IP filter which assigns flags to the addresses.
+ *
+ * @param localFlags Flags of addresses in the local network.
+ * @param otherFlags Flags of all other addresses.
+ */
+lt::ip_filter TorrentNetworkPolicy::filter(int localFlags, int otherFlags) const
+{
+	lt::ip_filter filter;
+	filter.add_rule(lt::address_v4::any(), lt::address_v4::broadcast(), otherFlags);
+	filter.add_rule(lt::address_v6::any(), maskAddress(lt::address_v6::any(), 0, true),
+	                otherFlags);
+	for (const Subnet &s : mSubnets) {
+		filter.add_rule(s.address, maskAddress(s.address, s.prefix, true), localFlags);
+	}
+	return filter;
+}
+
+bool TorrentNetworkPolicy::addSubnet(const char *address, int prefix)
+{
+	lt::error_code error;
+	const lt::address a = unmapped(lt::address::from_string(address, error));
+	if (error)
+		return false;
+	const int bits = a.is_v4() ? 32 : 128;
+	if (prefix < 0)
+		prefix = bits;
+	if (prefix > bits)
+		return false;
+	mSubnets.push_back(Subnet{maskAddress(a, prefix, false), prefix});
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+// Keeps the first prefix bits and clears the others or sets them if last is
+// true.
+template<class Bytes>
+Bytes maskBytes(Bytes bytes, int prefix, bool last)
+{
+	for (std::size_t i = 0; i < bytes.size(); ++i) {
+		const int bits = std::min(std::max(prefix - 8 * (int) i, 0), 8);
+		const unsigned char mask = 0xff00 >> bits;
+		bytes[i] = last ? (unsigned char) (bytes[i] | ~mask) : (unsigned char) (bytes[i] & mask);
+	}
+	return bytes;
+}
+
+// Returns the first address of the subnet or the last one if last is true.
+lt::address maskAddress(const lt::address &address, int prefix, bool last)
+{
+	if (address.is_v4())
+		return lt::address_v4(maskBytes(address.to_v4().to_bytes(), prefix, last));
+	else
+		return lt::address_v6(maskBytes(address.to_v6().to_bytes(), prefix, last));
+}
+
+// Returns IPv4 addresses which are mapped to IPv6 as IPv4 addresses.
+lt::address unmapped(const lt::address &address)
+{
+	if (address.is_v6() && address.to_v6().is_v4_mapped())
+		return address.to_v6().to_v4();
+	return address;
+}
@@ -0,0 +1,64 @@
+#ifndef TORRENTNETWORKPOLICY_H
+#define TORRENTNETWORKPOLICY_H
+
+#include <string>
+#include <vector>
+
+#include <libtorrent/address.hpp>
+
+namespace libtorrent {
+class ip_filter;
+}
+
+
+//! Peers and payload rates of the local network and the internet.
+struct TorrentNetworkTraffic {
+	int lanPeers = 0;
+	int lanDownloadRate = 0;
+	int lanUploadRate = 0;
+	int wanPeers = 0;
+	int wanDownloadRate = 0;
+	int wanUploadRate = 0;
+};
+
+/**
+ * @brief Separates peers of the local network from peers on the internet.
+ *
+ * Peers are local if their address belongs to a private (RFC 1918),
+ * link-local or loopback network or to one of the configured subnets. Traffic
+ * with local peers is never throttled. Traffic with other peers can be
+ * limited or blocked, so it does not eat the uplink of the venue.
+ *
+ * Libtorrent decides itself which peers are local for the rate limits, so
+ * configured subnets which are not private count as internet there. They are
+ * never blocked, though.
+ */
+class TorrentNetworkPolicy
+{
+public:
+	TorrentNetworkPolicy();
+
+	bool addSubnet(const std::string &subnet);
+	bool isLocal(const libtorrent::address &address) const;
+	libtorrent::ip_filter filter(int localFlags, int otherFlags) const;
+
+	//! Download limit for peers on the internet in bytes/s or 0 if unlimited.
+	int wanDownloadLimit = 0;
+	//! Upload limit for peers on the internet in bytes/s or 0 if unlimited.
+	int wanUploadLimit = 0;
+	//! Whether connections to peers on the internet are refused.
+	bool wanBlocked = false;
+
+private:
+	struct Subnet {
+		libtorrent::address address;
+		int prefix;
+	};
+
+	bool addSubnet(const char *address, int prefix);
+
+	std::vector<Subnet> mSubnets;
+
+};
+
+#endif // TORRENTNETWORKPOLICY_H
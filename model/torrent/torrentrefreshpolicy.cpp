@@ -0,0 +1,89 @@
+#include "torrentrefreshpolicy.h"
+
+#include <cassert>
+
+// Number of status updates without activity until the policy becomes dormant.
+static const int IDLE_UPDATES_UNTIL_DORMANT = 5;
+
+
+TorrentRefreshPolicy::TorrentRefreshPolicy(QObject *parent) :
+	QObject(parent),
+	mIntervals{500, 1000, 5000, 30000},
+	mRequests{0, 0, 0, 0},
+	mIntervalChanges(0),
+	mWindowVisible(false),
+	mWindowActive(false),
+	mTrayMenuVisible(false),
+	mIdleUpdates(0)
+{
+}
+
+//! Returns the level which applies currently.
+TorrentRefreshPolicy::Level TorrentRefreshPolicy::level() const
+{
+	if (mTrayMenuVisible || (mWindowVisible && mWindowActive))
+		return Fast;
+	if (mWindowVisible)
+		return Normal;
+	if (mIdleUpdates >= IDLE_UPDATES_UNTIL_DORMANT)
+		return Dormant;
+	return Hidden;
+}
+
+//! Counts a status request on the current level.
+void TorrentRefreshPolicy::recordRequest()
+{
+	++mRequests[level()];
+}
+
+/**
+ * @brief Reports the result of a status update.
+ *
+ * @param active Whether any torrent is transferring or checking data.
+ */
+void TorrentRefreshPolicy::reportActivity(bool active)
+{
+	change([this, active]() {
+		mIdleUpdates = active ? 0 : mIdleUpdates + 1;
+	});
+}
+
+void TorrentRefreshPolicy::setWindowVisible(bool visible)
+{
+	change([this, visible]() {mWindowVisible = visible;});
+}
+
+void TorrentRefreshPolicy::setWindowActive(bool active)
+{
+	change([this, active]() {mWindowActive = active;});
+}
+
+void TorrentRefreshPolicy::setTrayMenuVisible(bool visible)
+{
+	change([this, visible]() {mTrayMenuVisible = visible;});
+}
+
+//! Leaves the dormant level, e.g. because a torrent was added.
+void TorrentRefreshPolicy::wake()
+{
+	change([this]() {mIdleUpdates = 0;});
+}
+
+void TorrentRefreshPolicy::setInterval(Level level, int msec)
+{
+	assert(msec > 0);
+	change([this, level, msec]() {mIntervals[level] = msec;});
+}
+
+// Applies the change and emits intervalChanged if the interval differs.
+template<class Change>
+void TorrentRefreshPolicy::change(Change change)
+{
+	const int oldInterval = interval();
+	change();
+	const int newInterval = interval();
+	if (newInterval != oldInterval) {
+		++mIntervalChanges;
+		intervalChanged(newInterval);
+	}
+}
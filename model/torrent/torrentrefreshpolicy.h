@@ -0,0 +1,89 @@
+#ifndef TORRENTREFRESHPOLICY_H
+#define TORRENTREFRESHPOLICY_H
+
+#include <cstdint>
+
+#include <QObject>
+
+
+/**
+ * @brief Chooses how often TorrentSession requests the status of torrents.
+ *
+ * The interval depends on what the user can see and whether anything is
+ * happening:
+ *
+ * - Fast while the main window is active or the tray menu is open.
+ * - Normal while the main window is visible.
+ * - Hidden while no window is visible.
+ * - Dormant while no window is visible and nothing has been transferred or
+ *   checked for a few updates.
+ *
+ * The intervals of the levels are configurable. The policy counts the
+ * requests made on every level.
+ */
+class TorrentRefreshPolicy : public QObject
+{
+	Q_OBJECT
+	Q_PROPERTY(int fastInterval    READ fastInterval    WRITE setFastInterval)
+	Q_PROPERTY(int normalInterval  READ normalInterval  WRITE setNormalInterval)
+	Q_PROPERTY(int hiddenInterval  READ hiddenInterval  WRITE setHiddenInterval)
+	Q_PROPERTY(int dormantInterval READ dormantInterval WRITE setDormantInterval)
+	Q_PROPERTY(int interval READ interval NOTIFY intervalChanged)
+
+public:
+	enum Level {
+		Fast,
+		Normal,
+		Hidden,
+		Dormant,
+		LevelCount
+	}; Q_ENUM(Level)
+
+	explicit TorrentRefreshPolicy(QObject *parent = 0);
+
+	int fastInterval() const {return mIntervals[Fast];}
+	int normalInterval() const {return mIntervals[Normal];}
+	int hiddenInterval() const {return mIntervals[Hidden];}
+	int dormantInterval() const {return mIntervals[Dormant];}
+	void setFastInterval(int msec) {setInterval(Fast, msec);}
+	void setNormalInterval(int msec) {setInterval(Normal, msec);}
+	void setHiddenInterval(int msec) {setInterval(Hidden, msec);}
+	void setDormantInterval(int msec) {setInterval(Dormant, msec);}
+
+	Level level() const;
+	int interval() const {return mIntervals[level()];}
+
+	//! Number of requests made on the given level.
+	std::uint64_t requests(Level level) const {return mRequests[level];}
+	//! Number of times the interval has changed.
+	std::uint64_t intervalChanges() const {return mIntervalChanges;}
+
+	void recordRequest();
+	void reportActivity(bool active);
+
+signals:
+	//! Emitted with the new interval in milliseconds.
+	void intervalChanged(int interval);
+
+public slots:
+	void setWindowVisible(bool visible);
+	void setWindowActive(bool active);
+	void setTrayMenuVisible(bool visible);
+	void wake();
+
+private:
+	void setInterval(Level level, int msec);
+	template<class Change>
+	void change(Change change);
+
+	int mIntervals[LevelCount];
+	std::uint64_t mRequests[LevelCount];
+	std::uint64_t mIntervalChanges;
+	bool mWindowVisible;
+	bool mWindowActive;
+	bool mTrayMenuVisible;
+	int mIdleUpdates;
+
+};
+
+#endif // TORRENTREFRESHPOLICY_H
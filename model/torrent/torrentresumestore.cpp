@@ -0,0 +1,273 @@
+#include "torrentresumestore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+#include <libtorrent/add_torrent_params.hpp>
+#include <libtorrent/escape_string.hpp>
+#include <libtorrent/lazy_entry.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+namespace lt = libtorrent;
+
+// Time to collect changes before they are written together.
+static const std::chrono::milliseconds BATCH_DELAY(500);
+
+static const QString RESUME_SUFFIX = QStringLiteral(".fastresume");
+static const QString TORRENT_SUFFIX = QStringLiteral(".torrent");
+// Number of torrents which are passed on together when loading.
+static const std::size_t LOAD_BATCH_SIZE = 100;
+
+static bool parseTorrent(const QString &directory, const QString &resumeName,
+                         lt::add_torrent_params &params);
+
+
+TorrentResumeStore::TorrentResumeStore(const QString &directory) :
+	mDirectory(directory),
+	mWrites(0),
+	mBatches(0)
+{
+	QDir().mkpath(mDirectory);
+	mThread = std::thread(&TorrentResumeStore::run, this);
+}
+
+//! Writes the pending changes before returning.
+TorrentResumeStore::~TorrentResumeStore()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mChanged.notify_one();
+	mThread.join();
+}
+
+/**
+ * @brief Reads all stored torrents.
+ *
+ * The files are parsed by a pool of threads. The handler is called in the
+ * calling thread for every batch of torrents as soon as it is ready, so
+ * adding a batch overlaps with parsing the next one. May be called from
+ * another thread than the other functions. Torrents whose files are
+ * incomplete or invalid are skipped. The parameters contain the metadata, the
+ * resume data and the save path of the torrent.
+ *
+ * @param handler Receives the batches.
+ */
+void TorrentResumeStore::load(const BatchHandler &handler)
+{
+	const QDir dir(mDirectory);
+	const QStringList names = dir.entryList({QStringLiteral("*") + RESUME_SUFFIX}, QDir::Files);
+	if (names.isEmpty())
+		return;
+
+	std::mutex mutex;
+	std::condition_variable parsed;
+	std::vector<lt::add_torrent_params> ready;
+	std::atomic<int> next(0);
+	const int numThreads = std::min<int>(names.size(),
+			std::max(1u, std::thread::hardware_concurrency()));
+	int finishedThreads = 0;
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (int i = 0; i < numThreads; ++i) {
+		threads.emplace_back([&]() {
+			for (int index = next++; index < names.size(); index = next++) {
+				lt::add_torrent_params params;
+				if (!parseTorrent(mDirectory, names[index], params))
+					continue;
+				std::lock_guard<std::mutex> lock(mutex);
+				ready.push_back(std::move(params));
+				if (ready.size() == LOAD_BATCH_SIZE)
+					parsed.notify_one();
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			++finishedThreads;
+			parsed.notify_one();
+		});
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		parsed.wait(lock, [&]() {
+			return ready.size() >= LOAD_BATCH_SIZE || finishedThreads == numThreads;
+		});
+		const bool finished = finishedThreads == numThreads;
+		std::vector<lt::add_torrent_params> batch;
+		batch.swap(ready);
+		lock.unlock();
+		{
+			std::lock_guard<std::mutex> storeLock(mMutex);
+			for (const lt::add_torrent_params &params : batch) {
+				mTorrentFiles.insert(params.ti->info_hash());
+			}
+		}
+		if (!batch.empty())
+			handler(std::move(batch));
+		if (finished)
+			break;
+		lock.lock();
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+/**
+ * @brief Queues the resume data of a torrent to be written.
+ *
+ * @param infoHash The info hash of the torrent.
+ * @param resumeData The bencoded resume data.
+ * @param torrentFile The bencoded torrent file. May be empty if
+ *        TorrentResumeStore::hasTorrentFile returns <code>true</code>.
+ */
+void TorrentResumeStore::save(const lt::sha1_hash &infoHash,
+			std::vector<char> resumeData, std::vector<char> torrentFile)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (!torrentFile.empty())
+			mTorrentFiles.insert(infoHash);
+		Change &change = mChanges[lt::to_hex(infoHash.to_string())];
+		change.remove = false;
+		change.resumeData = std::move(resumeData);
+		if (!torrentFile.empty())
+			change.torrentFile = std::move(torrentFile);
+	}
+	mChanged.notify_one();
+}
+
+//! Queues the files of a removed torrent to be deleted.
+void TorrentResumeStore::remove(const lt::sha1_hash &infoHash)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTorrentFiles.erase(infoHash);
+		Change &change = mChanges[lt::to_hex(infoHash.to_string())];
+		change = Change();
+		change.remove = true;
+	}
+	mChanged.notify_one();
+}
+
+//! Returns whether the torrent file has been stored or queued already.
+bool TorrentResumeStore::hasTorrentFile(const lt::sha1_hash &infoHash) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mTorrentFiles.count(infoHash) != 0;
+}
+
+//! Blocks until all queued changes are written.
+void TorrentResumeStore::flush()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	++mFlushWaiters;
+	mChanged.notify_one();
+	mWritten.wait(lock, [this]() {return mChanges.empty() && !mWriting;});
+	--mFlushWaiters;
+}
+
+void TorrentResumeStore::run()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;) {
+		mChanged.wait(lock, [this]() {return !mChanges.empty() || mStopping;});
+		if (mChanges.empty())
+			return;
+		// Collect more changes unless somebody waits for them.
+		mChanged.wait_for(lock, BATCH_DELAY, [this]() {
+			return mStopping || mFlushWaiters > 0;
+		});
+
+		std::map<std::string, Change> changes;
+		changes.swap(mChanges);
+		mWriting = true;
+		lock.unlock();
+		for (const auto &change : changes) {
+			write(change.first, change.second);
+		}
+		++mBatches;
+		lock.lock();
+		mWriting = false;
+		mWritten.notify_all();
+	}
+}
+
+void TorrentResumeStore::write(const std::string &name, const Change &change)
+{
+	const QDir dir(mDirectory);
+	const QString base = QString::fromStdString(name);
+	if (change.remove) {
+		QFile::remove(dir.filePath(base + RESUME_SUFFIX));
+		QFile::remove(dir.filePath(base + TORRENT_SUFFIX));
+		++mWrites;
+		return;
+	}
+	// Write the torrent file first and skip the resume data if that fails, so
+	// the resume data never refers to a missing torrent file.
+	const std::pair<QString, const std::vector<char>*> files[] = {
+		{base + TORRENT_SUFFIX, &change.torrentFile},
+		{base + RESUME_SUFFIX, &change.resumeData}
+	};
+	for (const auto &file : files) {
+		if (file.second->empty())
+			continue;
+		QSaveFile out(dir.filePath(file.first));
+		if (!out.open(QFile::WriteOnly)
+				|| out.write(file.second->data(), file.second->size())
+				   != (qint64) file.second->size()
+				|| !out.commit()) {
+			qWarning() << "Could not write" << out.fileName() << out.errorString();
+			// Let the engine pass the torrent file again with the next save.
+			if (file.second == &change.torrentFile) {
+				lt::sha1_hash infoHash;
+				if (lt::from_hex(name.c_str(), name.size(),
+				                 reinterpret_cast<char*>(infoHash.begin()))) {
+					std::lock_guard<std::mutex> lock(mMutex);
+					mTorrentFiles.erase(infoHash);
+				}
+			}
+			return;
+		}
+		++mWrites;
+	}
+}
+
+// Reads a stored torrent. Returns false if its files are incomplete or invalid.
+static bool parseTorrent(const QString &directory, const QString &resumeName,
+                         lt::add_torrent_params &params)
+{
+	// Do not share a QDir between the threads, it caches data lazily.
+	const QString base = directory + QLatin1Char('/')
+			+ resumeName.left(resumeName.size() - RESUME_SUFFIX.size());
+	QFile resumeFile(base + RESUME_SUFFIX);
+	QFile torrentFile(base + TORRENT_SUFFIX);
+	if (!resumeFile.open(QFile::ReadOnly) || !torrentFile.open(QFile::ReadOnly))
+		return false;
+	const QByteArray resume = resumeFile.readAll();
+	const QByteArray torrent = torrentFile.readAll();
+
+	lt::error_code error;
+	boost::intrusive_ptr<lt::torrent_info> info(
+			new lt::torrent_info(torrent.constData(), torrent.size(), error));
+	if (error)
+		return false;
+	lt::lazy_entry entry;
+	if (lt::lazy_bdecode(resume.constData(), resume.constData() + resume.size(),
+	                     entry, error) != 0
+			|| entry.type() != lt::lazy_entry::dict_t) {
+		return false;
+	}
+
+	params.ti = info;
+	params.save_path = entry.dict_find_string_value("save_path");
+	params.resume_data.assign(resume.constData(), resume.constData() + resume.size());
+	return !params.save_path.empty();
+}
@@ -0,0 +1,90 @@
+#ifndef TORRENTRESUMESTORE_H
+#define TORRENTRESUMESTORE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QString>
+
+#include <libtorrent/peer_id.hpp>
+
+namespace libtorrent {
+struct add_torrent_params;
+}
+
+
+/**
+ * @brief Persists the fast resume data of torrents.
+ *
+ * Every torrent is stored as two files named after its info hash: the torrent
+ * file and the resume data. Writes are collected for a short time and then
+ * written together by a background thread. Every file is replaced atomically,
+ * so a crash leaves either the old or the new version.
+ *
+ * TorrentResumeStore::save, TorrentResumeStore::remove and
+ * TorrentResumeStore::hasTorrentFile are meant to be called from the thread of
+ * TorrentEngine. TorrentResumeStore::load may run in another thread meanwhile.
+ */
+class TorrentResumeStore
+{
+public:
+	explicit TorrentResumeStore(const QString &directory);
+	~TorrentResumeStore();
+
+	//! Receives a batch of torrents restored by TorrentResumeStore::load.
+	typedef std::function<void(std::vector<libtorrent::add_torrent_params>)> BatchHandler;
+
+	const QString &directory() const {return mDirectory;}
+
+	void load(const BatchHandler &handler);
+	void save(const libtorrent::sha1_hash &infoHash, std::vector<char> resumeData,
+	          std::vector<char> torrentFile = std::vector<char>());
+	void remove(const libtorrent::sha1_hash &infoHash);
+	bool hasTorrentFile(const libtorrent::sha1_hash &infoHash) const;
+	void flush();
+
+	//! Number of files written successfully or removed.
+	std::uint64_t writes() const {return mWrites;}
+	//! Number of batches the files were written in.
+	std::uint64_t batches() const {return mBatches;}
+
+private:
+	TorrentResumeStore(const TorrentResumeStore &) = delete;
+	TorrentResumeStore &operator=(const TorrentResumeStore &) = delete;
+
+	// A pending change of a torrent. Empty data keeps the file unchanged.
+	struct Change {
+		std::vector<char> resumeData;
+		std::vector<char> torrentFile;
+		bool remove = false;
+	};
+
+	void run();
+	void write(const std::string &name, const Change &change);
+
+	const QString mDirectory;
+
+	std::thread mThread;
+	mutable std::mutex mMutex;
+	std::set<libtorrent::sha1_hash> mTorrentFiles;
+	std::condition_variable mChanged;
+	std::condition_variable mWritten;
+	std::map<std::string, Change> mChanges;
+	bool mWriting = false;
+	int mFlushWaiters = 0;
+	bool mStopping = false;
+
+	std::atomic<std::uint64_t> mWrites;
+	std::atomic<std::uint64_t> mBatches;
+
+};
+
+#endif // TORRENTRESUMESTORE_H
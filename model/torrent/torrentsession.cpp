@@ -1,13 +1,20 @@
 #include "torrentsession.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
-#include <deque>
 #include <map>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QStorageInfo>
+#include <QThread>
 #include <QTimer>
 #include <QUrl>
 
@@ -15,58 +22,80 @@
 #include <libtorrent/alert.hpp>
 #include <libtorrent/alert_types.hpp>
 #include <libtorrent/error_code.hpp>
+#include <libtorrent/file_storage.hpp>
 #include <libtorrent/magnet_uri.hpp>
+#include <libtorrent/peer_info.hpp>
 #include <libtorrent/session.hpp>
+#include <libtorrent/session_settings.hpp>
+#include <libtorrent/session_status.hpp>
 #include <libtorrent/storage_defs.hpp>
+#include <libtorrent/time.hpp>
 #include <libtorrent/torrent_handle.hpp>
 #include <libtorrent/torrent_info.hpp>
+#include <libtorrent/version.hpp>
 
 #include "torrent.h"
+#include "torrentdetails.h"
+#include "torrentdisksettings.h"
+#include "torrentengine.h"
+#include "torrentfilereuse.h"
 #include "torrentinfo.h"
+#include "torrentrefreshpolicy.h"
+#include "torrentsessionprofile.h"
 #include "torrentsessionstatus.h"
+#include "torrentstatusobject.h"
 #include "torrentsmodel.h"
+#include "torrentstreamer.h"
 #include "torrentstatus.h"
 
 namespace lt = libtorrent;
 
+static bool isSessionAlert(int type);
+static lt::sha1_hash infoHashOf(const lt::torrent_alert &alert);
+static bool isActive(const lt::torrent_status &status);
+static bool isChecking(const lt::torrent_status &status);
+static qint64 missingBytes(const lt::torrent_info &info, const QDir &saveDir,
+                           const std::vector<bool> &shared);
+
 
 TorrentSession::TorrentSession(QObject *parent) :
 	QObject(parent),
-	mSessionHandle(new lt::session(
-			  lt::fingerprint("LC", 1, 0, 0, 0)
-			, std::make_pair(6881, 6891)
-			, "0.0.0.0"
-			, lt::session::start_default_features
-					| lt::session::add_default_plugins
-			, lt::alert::error_notification
-					| lt::alert::peer_notification
-					| lt::alert::port_mapping_notification
-					| lt::alert::storage_notification
-					| lt::alert::tracker_notification
-					| lt::alert::status_notification
-					| lt::alert::ip_block_notification
-					| lt::alert::performance_warning
-					| lt::alert::ip_block_notification
-					| lt::alert::storage_notification
-			TORRENT_LOGPATH_ARG_DEFAULT)),
+	mEngine(new TorrentEngine()),
+	mEngineThread(new QThread(this)),
 	mStatus(new TorrentSessionStatus(this)),
-	mModel(new TorrentsModel(this, this))
+	mModel(new TorrentsModel(this, this)),
+	mStatusTimer(new QTimer(this)),
+	mRefreshPolicy(new TorrentRefreshPolicy(this))
 {
-	mSessionHandle->start_lsd();
-	// TODO use prioritize partial pieces?
-	// TODO use prefer whole pieces (or another threshold)?
-	// TOOO block global IPs?
-	// TODO set sequential download if the torrent has good availability
+	mStartupTimer.start();
 
-	mStatus->loadFromLibtorrent(mSessionHandle->status());
+	// Run the engine in its own thread. Events are handled in the thread of
+	// the session. The torrents of the last run are restored from the resume
+	// data.
+	mEngine->setResumeDirectory(
+				QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+				+ QStringLiteral("/resume"));
+	mEngine->moveToThread(mEngineThread);
+	connect(mEngine.get(), &TorrentEngine::eventsAvailable,
+	        this, &TorrentSession::update, Qt::QueuedConnection);
+	mEngineThread->start();
+	QMetaObject::invokeMethod(mEngine.get(), "start", Qt::QueuedConnection);
+	setAlertDelivery(NotifyAlerts);
+	setProfile(LanProfile);
 
-	QTimer *timer = new QTimer(this);
-	connect(timer, SIGNAL(timeout()), this, SLOT(update()));
-	timer->start(100);
+	connect(mStatusTimer, SIGNAL(timeout()), this, SLOT(requestStatusUpdates()));
+	connect(mRefreshPolicy, &TorrentRefreshPolicy::intervalChanged,
+	        this, &TorrentSession::onRefreshIntervalChanged);
+	mStatusTimer->start(mRefreshPolicy->interval());
 }
 
 TorrentSession::~TorrentSession()
 {
+	// Stop the engine before its thread since the session of libtorrent must
+	// be destroyed in the thread of the engine.
+	QMetaObject::invokeMethod(mEngine.get(), "stop", Qt::BlockingQueuedConnection);
+	mEngineThread->quit();
+	mEngineThread->wait();
 }
 
 const TorrentSessionStatus *TorrentSession::status() const
@@ -88,15 +117,155 @@ TorrentsModel *TorrentSession::torrents() const
  */
 QVector<Torrent *> TorrentSession::getTorrentsAsVector() const
 {
-	QVector<Torrent*> list(mTorrentMap.size());
-	int i = 0;
-	for (const auto &entry : mTorrentMap) {
-		assert(i < list.size());
-		list[i++] = entry.second.get();
+	QVector<Torrent*> list;
+	list.reserve(mTorrents.size());
+	for (Torrent *t : mTorrents) {
+		list.push_back(t);
 	}
 	return list;
 }
 
+/**
+ * @brief Returns the counters collected by the session.
+ */
+TorrentSessionMetrics TorrentSession::metrics() const
+{
+	TorrentSessionMetrics metrics = mMetrics;
+	metrics.alertTicks = mEngine->alertTicks();
+	metrics.idleAlertTicks = mEngine->idleAlertTicks();
+	metrics.fastStatusRequests = mRefreshPolicy->requests(TorrentRefreshPolicy::Fast);
+	metrics.normalStatusRequests = mRefreshPolicy->requests(TorrentRefreshPolicy::Normal);
+	metrics.hiddenStatusRequests = mRefreshPolicy->requests(TorrentRefreshPolicy::Hidden);
+	metrics.dormantStatusRequests = mRefreshPolicy->requests(TorrentRefreshPolicy::Dormant);
+	metrics.statusIntervalChanges = mRefreshPolicy->intervalChanges();
+	metrics.statusInterval = mRefreshPolicy->interval();
+	for (const Torrent *t : mTorrents) {
+		if (t->metadata()) {
+			++metrics.metadataTorrents;
+			metrics.metadataBytes += t->metadata()->memoryUsage();
+		}
+	}
+	metrics.resumeWrites = mEngine->resumeWrites();
+	metrics.resumeBatches = mEngine->resumeBatches();
+	const TorrentStreamer::Stats streams = mEngine->streamer()->stats();
+	metrics.streamFirstBytes = streams.firstBytesStreams;
+	metrics.streamFirstBytesTimeSum = streams.firstBytesTimeSum;
+	metrics.streamedTorrents = streams.streamedTorrents;
+	metrics.streamedBytes = streams.streamedBytes;
+	metrics.streamedTime = streams.streamedTime;
+	metrics.downloadedTorrents = streams.downloadedTorrents;
+	metrics.downloadedBytes = streams.downloadedBytes;
+	metrics.downloadedTime = streams.downloadedTime;
+	return metrics;
+}
+
+//! Records the time until the GUI has shown its first frame.
+void TorrentSession::reportFirstFrame()
+{
+	if (mMetrics.startupToFirstFrameTime < 0)
+		mMetrics.startupToFirstFrameTime = mStartupTimer.elapsed();
+}
+
+/**
+ * @brief Changes the way alerts are delivered by libtorrent.
+ *
+ * With TorrentSession::PollAlerts, the alert queue is checked every 100 ms. With
+ * TorrentSession::NotifyAlerts, the network thread of libtorrent hands over
+ * every alert and wakes up the engine. The alert timer is only kept as a
+ * fallback then.
+ *
+ * @param delivery The new delivery mode.
+ */
+void TorrentSession::setAlertDelivery(AlertDelivery delivery)
+{
+	mAlertDelivery = delivery;
+	TorrentEngine *engine = mEngine.get();
+	const bool notify = delivery == NotifyAlerts;
+	mEngine->post([engine, notify](lt::session &) {
+		engine->setAlertNotification(notify);
+	});
+}
+
+/**
+ * @brief Tunes the session for the given network.
+ *
+ * The settings are applied to the running session. See TorrentSessionProfile
+ * for the settings of each profile.
+ */
+void TorrentSession::setProfile(Profile profile)
+{
+	mProfile = profile;
+	mEngine->post([profile](lt::session &session) {
+		lt::session_settings settings = session.settings();
+		TorrentSessionProfile::apply(profile, settings);
+		session.set_settings(settings);
+#ifndef TORRENT_DISABLE_ENCRYPTION
+		lt::pe_settings encryption = session.get_pe_settings();
+		TorrentSessionProfile::apply(profile, encryption);
+		session.set_pe_settings(encryption);
+#endif
+	});
+}
+
+/**
+ * @brief Sets how peers of the local network and the internet are treated.
+ *
+ * The counters of both networks are part of the status of the session.
+ */
+void TorrentSession::setNetworkPolicy(const TorrentNetworkPolicy &policy)
+{
+	mNetworkPolicy = policy;
+	TorrentEngine *engine = mEngine.get();
+	mEngine->post([engine, policy](lt::session &) {
+		engine->setNetworkPolicy(policy);
+	});
+}
+
+/**
+ * @brief Tunes the disk I/O of the running session.
+ *
+ * The effect is visible in the disk counters of the session status.
+ */
+void TorrentSession::setDiskSettings(const TorrentDiskSettings &settings)
+{
+	mEngine->post([settings](lt::session &session) {
+		settings.apply(session);
+	});
+}
+
+/**
+ * @brief Sets the torrent whose details are fetched with every status update.
+ *
+ * Pieces, trackers and peers are only collected for this torrent. The details
+ * of the previous torrent are dropped.
+ *
+ * @param torrent The torrent or <code>nullptr</code> to fetch no details.
+ */
+void TorrentSession::setDetailedTorrent(Torrent *torrent)
+{
+	if (torrent == mDetailedTorrent)
+		return;
+	if (mDetailedTorrent)
+		mDetailedTorrent->mDetails.reset();
+	mDetailedTorrent = torrent;
+	if (torrent)
+		requestDetails(torrent);
+}
+
+/**
+ * @brief Removes all alert subscriptions of the given receiver.
+ *
+ * @param receiver The receiver passed to TorrentSession::subscribeAlert.
+ */
+void TorrentSession::unsubscribeAlerts(QObject *receiver)
+{
+	mAlertRegistry.unsubscribe(receiver);
+	if (mAlertSubscribers.remove(receiver)) {
+		disconnect(receiver, &QObject::destroyed,
+		           this, &TorrentSession::onAlertSubscriberDestroyed);
+	}
+}
+
 /**
  * @brief Adds a new torrent to the session.
  *
@@ -104,34 +273,174 @@ QVector<Torrent *> TorrentSession::getTorrentsAsVector() const
  * returned. You can check what happend with Torrent::wasAdded(). It should be
  * <code>false</code> for newly added torrents.
  *
- * @param info Content of the torrent file.
+ * Files which are identical in an older version of the torrent in this
+ * session, i.e. one with the same name, are shared with the new version
+ * before it is checked, so only the changed files are downloaded.
+ *
+ * @param info Content of the torrent file. It is shared with libtorrent and
+ *        must not be modified afterwards.
  * @param savePath The directory where the file should be saved.
  * @param flags Flags which should be set for this torrent.
- * @return Returns the torrent handled by this session.
+ * @param allocation How the files of the torrent are allocated.
+ * @return Returns the torrent handled by this session or <code>nullptr</code>
+ *         if there is not enough free space for the torrent.
  */
-Torrent *TorrentSession::addTorrent(const lt::torrent_info &info, const QDir &saveDir,
-			uint64_t flags)
+Torrent *TorrentSession::addTorrent(boost::intrusive_ptr<lt::torrent_info> info,
+			const QDir &saveDir, uint64_t flags, Allocation allocation)
 {
-	assert(info.is_valid());
-	std::unique_ptr<Torrent> &t = mTorrentMap[info.info_hash()];
+	const QVector<Torrent*> torrents = addTorrents({info}, saveDir, flags, allocation);
+	return torrents.isEmpty() ? nullptr : torrents.front();
+}
 
-	if (t) {
-		// Torrent already added
-		return t.get();
-	} else {
+/**
+ * @brief Adds multiple torrents to the session at once.
+ *
+ * Behaves like TorrentSession::addTorrent for every torrent, but all of them
+ * are passed to the engine with a single command. The models insert them with
+ * a single update when their alerts arrive.
+ *
+ * Nothing is added if the files of the new torrents do not fit into the free
+ * space of the save directory. Files which exist already are taken into
+ * account.
+ *
+ * @param infos Contents of the torrent files. They are shared with libtorrent
+ *        and must not be modified afterwards.
+ * @param saveDir The directory where the files should be saved.
+ * @param flags Flags which should be set for all torrents.
+ * @param allocation How the files of the torrents are allocated.
+ * @return Returns the torrents handled by this session in the order of infos
+ *         or an empty vector if there is not enough free space.
+ */
+QVector<Torrent*> TorrentSession::addTorrents(
+			const std::vector<boost::intrusive_ptr<lt::torrent_info>> &infos,
+			const QDir &saveDir, std::uint64_t flags, Allocation allocation)
+{
+	typedef std::pair<lt::sha1_hash, boost::intrusive_ptr<const lt::torrent_info>> Version;
+	// The files of an old version and how much of them has been verified.
+	struct FileSource {
+		boost::intrusive_ptr<const lt::torrent_info> info;
+		std::string savePath;
+		std::vector<std::int64_t> progress;
+	};
+	const std::string savePath = QDir::toNativeSeparators(saveDir.absolutePath())
+			.toLocal8Bit().constData(); // TODO encoding?
+	const bool seeding = flags & lt::add_torrent_params::flag_seed_mode;
+
+	// Older versions of the torrents may already have most of the files. Any
+	// torrent with the same name is a candidate.
+	std::multimap<std::string, Version> versionsByName;
+	if (!seeding) {
+		for (Torrent *other : mTorrents) {
+			const TorrentInfo *metadata = other->metadata();
+			if (metadata) {
+				versionsByName.emplace(metadata->data()->name(),
+				                       Version(metadata->data()->info_hash(), metadata->data()));
+			}
+		}
+	}
+
+	// Fail before libtorrent starts to allocate the files. Files which are
+	// shared with an older version take no space.
+	const QStorageInfo storage(saveDir);
+	if (!seeding && storage.isValid()) {
+		// The same torrent may be passed more than once.
+		std::set<lt::sha1_hash> counted;
+		qint64 missing = 0;
+		for (const boost::intrusive_ptr<lt::torrent_info> &info : infos) {
+			if (mTorrents.find(info->info_hash()) || !counted.insert(info->info_hash()).second)
+				continue;
+			std::vector<bool> shared(info->num_files(), false);
+			const auto range = versionsByName.equal_range(info->name());
+			for (auto it = range.first; it != range.second; ++it) {
+				const std::vector<int> identical =
+						TorrentFileReuse::identicalFiles(*info, *it->second.second);
+				for (std::size_t i = 0; i < identical.size(); ++i) {
+					shared[i] = shared[i] || identical[i] >= 0;
+				}
+			}
+			missing += missingBytes(*info, saveDir, shared);
+		}
+		if (missing > storage.bytesAvailable()) {
+			qWarning() << "Not enough free space in" << saveDir.absolutePath()
+			           << "for" << missing << "bytes.";
+			return QVector<Torrent*>();
+		}
+	}
+
+	QVector<Torrent*> torrents;
+	torrents.reserve(infos.size());
+	std::vector<std::pair<lt::add_torrent_params, std::vector<Version>>> added;
+	added.reserve(infos.size());
+	for (const boost::intrusive_ptr<lt::torrent_info> &info : infos) {
+		assert(info->is_valid());
+		Torrent *t = mTorrents.find(info->info_hash());
+		if (t) {
+			// Torrent already added
+			torrents.push_back(t);
+			continue;
+		}
 		// Torrent will be added
-		QString savePath = QDir::toNativeSeparators(saveDir.absolutePath());
 		lt::add_torrent_params params;
-		params.ti = new lt::torrent_info(info);
-		params.save_path = savePath.toLocal8Bit().constData(); // TODO encoding?
-		params.storage_mode = lt::storage_mode_allocate;
-		params.flags = flags | lt::add_torrent_params::flag_update_subscribe; // TODO default flags?
-		mSessionHandle->async_add_torrent(params);
+		params.ti = info;
+		params.save_path = savePath;
+		params.storage_mode = storageMode(allocation);
+		// The IP filter blocks the internet if the network policy says so.
+		params.flags = flags | lt::add_torrent_params::flag_update_subscribe // TODO default flags?
+				| lt::add_torrent_params::flag_apply_ip_filter;
+
+		std::vector<Version> versions;
+		const auto range = versionsByName.equal_range(info->name());
+		for (auto it = range.first; it != range.second; ++it) {
+			versions.push_back(it->second);
+		}
+		added.emplace_back(std::move(params), std::move(versions));
 
-		t.reset(new Torrent(this));
-		t->mMetadata.reset(new TorrentInfo(info)); // TODO should I avoid copying lt::torrent_info?
-		return t.get();
+		t = mTorrents.insert(info->info_hash(),
+		                     std::unique_ptr<Torrent>(new Torrent(this)));
+		t->mMetadata.reset(new TorrentInfo(info));
+		torrents.push_back(t);
+		if (!seeding)
+			startDownloadTimer(info->info_hash(), allocation);
 	}
+	if (added.empty())
+		return torrents;
+
+	TorrentEngine *engine = mEngine.get();
+	mEngine->post([engine, added](lt::session &session) {
+		for (const auto &torrent : added) {
+			const lt::add_torrent_params &params = torrent.first;
+			if (torrent.second.empty()) {
+				session.async_add_torrent(params);
+				continue;
+			}
+			// Find the files of the old versions which are complete.
+			std::vector<FileSource> sources;
+			for (const Version &version : torrent.second) {
+				try {
+					const lt::torrent_handle handle = session.find_torrent(version.first);
+					FileSource source;
+					source.info = version.second;
+					source.savePath = handle.status(lt::torrent_handle::query_save_path).save_path;
+					handle.file_progress(source.progress, lt::torrent_handle::piece_granularity);
+					sources.push_back(std::move(source));
+				} catch (const lt::libtorrent_exception &) {
+					// The old version has been removed meanwhile.
+				}
+			}
+			// Share them before the torrent is checked. Cloning or linking
+			// many files may take a while, so keep the engine responsive.
+			engine->postBackground([params, sources](lt::session &session) {
+				for (const FileSource &source : sources) {
+					TorrentFileReuse::reuseFiles(*params.ti, params.save_path,
+					                             *source.info, source.savePath,
+					                             source.progress);
+				}
+				session.async_add_torrent(params);
+			});
+		}
+	});
+	mRefreshPolicy->wake();
+	return torrents;
 }
 
 /**
@@ -144,11 +453,12 @@ Torrent *TorrentSession::addTorrent(const lt::torrent_info &info, const QDir &sa
  * @param uri The magnet link to add.
  * @param saveDir The directory where the file should be saved.
  * @param flags Flags which should be set for this torrent.
+ * @param allocation How the files of the torrent are allocated.
  * @return Returns the torrent handled by this session or <code>nullptr</code>
  *         if the link was not valid.
  */
 Torrent *TorrentSession::addTorrentMagnet(const QUrl &uri, const QDir &saveDir,
-			std::uint64_t flags)
+			std::uint64_t flags, Allocation allocation)
 {
 	lt::error_code error;
 	lt::add_torrent_params params;
@@ -158,21 +468,26 @@ Torrent *TorrentSession::addTorrentMagnet(const QUrl &uri, const QDir &saveDir,
 		return nullptr;
 	}
 
-	std::unique_ptr<Torrent> &t = mTorrentMap[params.info_hash];
+	Torrent *t = mTorrents.find(params.info_hash);
 
 	if (t) {
 		// Torrent already added
-		return t.get();
+		return t;
 	} else {
 		// Torrent will be added
 		QString savePath = QDir::toNativeSeparators(saveDir.absolutePath());
 		params.save_path = savePath.toLocal8Bit().constData(); // TODO encoding?
-		params.storage_mode = lt::storage_mode_allocate;
-		params.flags = flags | lt::add_torrent_params::flag_update_subscribe;
-		mSessionHandle->async_add_torrent(params);
+		params.storage_mode = storageMode(allocation);
+		params.flags = flags | lt::add_torrent_params::flag_update_subscribe
+				| lt::add_torrent_params::flag_apply_ip_filter;
+		mEngine->post([params](lt::session &session) {
+			session.async_add_torrent(params);
+		});
+		mRefreshPolicy->wake();
+		startDownloadTimer(params.info_hash, allocation);
 
-		t.reset(new Torrent(this));
-		return t.get();
+		return mTorrents.insert(params.info_hash,
+		                        std::unique_ptr<Torrent>(new Torrent(this)));
 	}
 }
 
@@ -192,11 +507,54 @@ void TorrentSession::removeTorrent(Torrent *torrent)
 {
 	assert(torrent->mSession == this);
 	if (torrent->wasAdded() && !torrent->mRemoving) {
-		mSessionHandle->remove_torrent(*torrent->mHandle);
+		removeFromEngine(*torrent->mHandle, 0);
 	}
 	torrent->mRemoving = true;
 }
 
+/**
+ * @brief Starts or stops streaming a torrent.
+ *
+ * Streamed torrents download the pieces behind their read cursor first and
+ * switch to sequential downloading if the swarm allows it. A torrent which
+ * has not been added yet starts streaming once it is added.
+ *
+ * @see TorrentStreamer
+ */
+void TorrentSession::setStreaming(Torrent *torrent, bool enabled)
+{
+	assert(torrent->mSession == this);
+	if (torrent->mStreaming == enabled)
+		return;
+	torrent->mStreaming = enabled;
+	if (torrent->wasAdded())
+		streamInEngine(*torrent->mHandle, enabled);
+}
+
+/**
+ * @brief Moves the read cursor of a streamed torrent.
+ *
+ * @param torrent The streamed torrent.
+ * @param fileIndex The file which is read.
+ * @param offset The position in the file.
+ */
+void TorrentSession::setReadCursor(Torrent *torrent, int fileIndex, qint64 offset)
+{
+	assert(torrent->mSession == this);
+	const TorrentInfo *metadata = torrent->metadata();
+	if (!torrent->mStreaming || !torrent->wasAdded() || !metadata)
+		return;
+	if (fileIndex < 0 || fileIndex >= metadata->fileCount()
+			|| offset < 0 || offset >= metadata->fileSize(fileIndex))
+		return;
+	const int piece = metadata->data()->map_file(fileIndex, offset, 0).piece;
+	TorrentStreamer *streamer = mEngine->streamer();
+	const lt::torrent_handle handle = *torrent->mHandle;
+	mEngine->post([streamer, handle, piece](lt::session &) {
+		streamer->setReadCursor(handle, piece);
+	});
+}
+
 /**
  * @brief Removes torrent from the session and deletes all files from the disk.
  *
@@ -215,64 +573,91 @@ void TorrentSession::deleteTorrentFiles(Torrent *torrent)
 {
 	assert(torrent->mSession == this);
 	if (torrent->wasAdded() && !torrent->mRemoving) {
-		mSessionHandle->remove_torrent(*torrent->mHandle, lt::session::delete_files);
+		removeFromEngine(*torrent->mHandle, lt::session::delete_files);
 	}
 	torrent->mRemoving = true;
 	torrent->mDeleting = true;
 }
 
+/**
+ * @brief Saves the resume data of all torrents and closes the session.
+ *
+ * Blocks until the resume data is written. Commands like adding torrents are
+ * ignored afterwards.
+ */
 void TorrentSession::close()
 {
-	// TODO
+	mStatusTimer->stop();
+	QMetaObject::invokeMethod(mEngine.get(), "stop", Qt::BlockingQueuedConnection);
 	closed();
 }
 
 void TorrentSession::update()
 {
-	std::deque<lt::alert*> alerts;
-	mSessionHandle->pop_alerts(&alerts);
+	// Take all events which are ready. Acknowledge them first to get notified
+	// about events which are added meanwhile.
+	mEngine->acknowledgeEvents();
+	TorrentEngine::Event event;
+	while (mEngine->takeEvent(event)) {
+		// Handle results of queries.
+		if (event.details) {
+			loadDetails(event.infoHash, std::move(event.details));
+			continue;
+		}
+		if (event.resumed) {
+			resumeTorrents(*event.resumed);
+			continue;
+		}
+		const lt::alert *alert = event.alert.get();
 
-	for (const lt::alert *alert : alerts) {
+		// Measure the time the alert was waiting.
+		const std::uint64_t latency = std::max<std::int64_t>(
+					0, lt::total_microseconds(lt::time_now_hires() - alert->timestamp()));
+		mMetrics.alertLatencySum += latency;
+		mMetrics.alertLatencyMax = std::max(mMetrics.alertLatencyMax, latency);
+		++mMetrics.alerts;
 
-		// Set the handle if a torrent was added.
-		Torrent *t = nullptr;
-		if (alert->type() == lt::torrent_added_alert::alert_type
-				|| alert->type() == lt::add_torrent_alert::alert_type) {
-
-			const lt::torrent_alert *a =
-					static_cast<const lt::torrent_alert*>(alert);
-			t = mTorrentMap[a->handle.info_hash()].get();
-			assert(t);
-			t->mHandle.reset(new lt::torrent_handle(a->handle));
+		// Skip alerts nobody is interested in.
+		const int type = alert->type();
+		const bool handledBySession = isSessionAlert(type);
+		if (!handledBySession && !mAlertRegistry.hasSubscribers(type)) {
+			continue;
 		}
 
 		// Update info hash in map if it changed
-		if (alert->type() == lt::torrent_update_alert::alert_type) {
+		if (type == lt::torrent_update_alert::alert_type) {
 			const lt::torrent_update_alert *a =
 					static_cast<const lt::torrent_update_alert*>(alert);
-			auto &newPos = mTorrentMap[a->new_ih];
-			auto it = mTorrentMap.find(a->old_ih);
-			assert(newPos == nullptr);
-			assert(it != mTorrentMap.end());
-			newPos = std::move(it->second);
-			mTorrentMap.erase(it);
+			std::unique_ptr<Torrent> moved = mTorrents.take(a->old_ih);
+			assert(moved);
+			assert(!mTorrents.find(a->new_ih));
+			mTorrents.insert(a->new_ih, std::move(moved));
 		}
 
-		// Check whether it is an torrent alert and set `t`.
-		if (t == nullptr) {
-			const lt::torrent_alert *ta =
-					dynamic_cast<const lt::torrent_alert*>(alert);
-			if (ta) {
-				t = mTorrentMap[ta->handle.info_hash()].get();
-				assert(t);
-			}
+		// Look up the torrent once if it is an torrent alert.
+		Torrent *t = nullptr;
+		if (handledBySession ? type != lt::state_update_alert::alert_type
+		                     : mAlertRegistry.isTorrentAlert(type)) {
+			const lt::torrent_alert *a =
+					static_cast<const lt::torrent_alert*>(alert);
+			t = mTorrents.find(infoHashOf(*a));
+		}
+
+		// Set the handle if a torrent was added.
+		if (type == lt::torrent_added_alert::alert_type
+				|| type == lt::add_torrent_alert::alert_type) {
+			const lt::torrent_alert *a =
+					static_cast<const lt::torrent_alert*>(alert);
+			assert(t);
+			if (t)
+				t->mHandle.reset(new lt::torrent_handle(a->handle));
 		}
 
-		// Fire the alert signal.
-		this->alert(*alert, t);
+		// Pass the alert to the subscribers.
+		mAlertRegistry.dispatch(*alert, t);
 
 		// Do private handling
-		switch (alert->type()) {
+		switch (type) {
 		case lt::add_torrent_alert::alert_type:
 		{
 			const lt::add_torrent_alert *a =
@@ -281,15 +666,21 @@ void TorrentSession::update()
 			if (a->error) {
 				t->addFailed(a->error);
 				t->removed(); // TODO should I call this signal ?
-				int ret = mTorrentMap.erase(a->params.ti ? a->params.ti->info_hash() : a->params.info_hash);
+				if (t == mDetailedTorrent)
+					mDetailedTorrent = nullptr;
+				mResumingTorrents.erase(infoHashOf(*a));
+				mDownloadTimers.erase(infoHashOf(*a));
+				bool ret = mTorrents.erase(infoHashOf(*a));
 				assert(ret);
 			} else {
 				t->mAdded = true;
 				t->added();
+				if (t->mStreaming)
+					streamInEngine(*t->mHandle, true);
 				if (t->mDeleting) {
-					mSessionHandle->remove_torrent(*t->mHandle, lt::session::delete_files);
+					removeFromEngine(*t->mHandle, lt::session::delete_files);
 				} else if (t->mRemoving) {
-					mSessionHandle->remove_torrent(*t->mHandle);
+					removeFromEngine(*t->mHandle, 0);
 				}
 			}
 			break;
@@ -301,7 +692,11 @@ void TorrentSession::update()
 			assert(t);
 			assert(t->mHandle->info_hash() == a->info_hash);
 			t->removed();
-			int ret = mTorrentMap.erase(a->info_hash);
+			if (t == mDetailedTorrent)
+				mDetailedTorrent = nullptr;
+			mResumingTorrents.erase(a->info_hash);
+			mDownloadTimers.erase(a->info_hash);
+			bool ret = mTorrents.erase(a->info_hash);
 			assert(ret);
 			break;
 		}
@@ -309,18 +704,22 @@ void TorrentSession::update()
 		{
 			const lt::torrent_deleted_alert *a =
 					static_cast<const lt::torrent_deleted_alert*>(alert);
-			assert(t);
-			assert(t->mHandle->info_hash() == a->info_hash);
-			t->deleted();
+			// The torrent may already be gone after torrent_removed_alert.
+			if (t) {
+				assert(t->mHandle->info_hash() == a->info_hash);
+				t->deleted();
+			}
 			break;
 		}
 		case lt::torrent_delete_failed_alert::alert_type:
 		{
 			const lt::torrent_delete_failed_alert *a =
 					static_cast<const lt::torrent_delete_failed_alert*>(alert);
-			assert(t);
-			assert(t->mHandle->info_hash() == a->info_hash);
-			t->deleteFailed(a->error);
+			// The torrent may already be gone after torrent_removed_alert.
+			if (t) {
+				assert(t->mHandle->info_hash() == a->info_hash);
+				t->deleteFailed(a->error);
+			}
 			break;
 		}
 		case lt::metadata_received_alert::alert_type:
@@ -329,7 +728,8 @@ void TorrentSession::update()
 					static_cast<const lt::metadata_received_alert*>(alert);
 			assert(t);
 			assert(*t->mHandle == a->handle);
-			t->mMetadata.reset(new TorrentInfo(*t->mHandle->torrent_file()));
+			assert(event.metadata);
+			t->mMetadata.reset(new TorrentInfo(event.metadata));
 			t->metadataReceived();
 			break;
 		}
@@ -346,28 +746,294 @@ void TorrentSession::update()
 		{
 			const lt::state_update_alert *a =
 					static_cast<const lt::state_update_alert*>(alert);
-			mNoUpdateCounter = 0;
 
+			// Load all states first and notify listeners once afterwards.
+			QVector<Torrent*> updated;
+			updated.reserve(a->status.size());
+			bool active = false;
+			const bool resuming = !mResumingTorrents.empty();
 			for (const lt::torrent_status &nts : a->status) {
-				Torrent *t = mTorrentMap[nts.info_hash].get();
+				active = active || isActive(nts);
+				if (resuming && !isChecking(nts))
+					mResumingTorrents.erase(nts.info_hash);
+				if (!mDownloadTimers.empty()) {
+					if (nts.total_payload_download > 0)
+						stopDownloadTimer(nts.info_hash);
+					else if (nts.is_finished) // complete without downloading
+						mDownloadTimers.erase(nts.info_hash);
+				}
+				Torrent *t = mTorrents.find(nts.info_hash);
 				assert(t);
 				assert(nts.info_hash == nts.handle.info_hash());
 				assert(*t->mHandle == nts.handle);
-				t->mStatus->loadFromLibtorrent(nts);
-				t->statusUpdated();
+				const TorrentStatus::Fields changed =
+						t->mStatus.loadFromLibtorrent(nts);
+				if (!changed)
+					continue;
+				if (t->mStatusObject)
+					t->mStatusObject->notify(changed);
+				updated.push_back(t);
 			}
+			if (!updated.isEmpty())
+				torrentsUpdated(updated);
+			if (resuming && mResumingTorrents.empty())
+				mMetrics.startupToSeedingTime = mStartupTimer.elapsed();
 
-			mStatus->loadFromLibtorrent(mSessionHandle->status());
+			assert(event.sessionStatus);
+			mStatus->loadFromLibtorrent(*event.sessionStatus);
+			if (event.networkTraffic)
+				mStatus->loadNetworkTraffic(*event.networkTraffic);
+			if (event.cacheStatus)
+				mStatus->loadCacheStatus(*event.cacheStatus);
 			statusUpdated();
+			mRefreshPolicy->reportActivity(active);
 			break;
 		}
 		}
+	}
+}
+
+void TorrentSession::requestStatusUpdates()
+{
+	mRefreshPolicy->recordRequest();
+	// The result is delivered as state_update_alert.
+	mEngine->post([](lt::session &session) {
+		session.post_torrent_updates();
+	});
+	if (mDetailedTorrent)
+		requestDetails(mDetailedTorrent);
+}
+
+/**
+ * @brief Fetches the details of a torrent in the thread of the engine.
+ *
+ * The result is passed back as event and loaded by
+ * TorrentSession::loadDetails.
+ */
+void TorrentSession::requestDetails(Torrent *torrent)
+{
+	if (!torrent->wasAdded() || torrent->mRemoving)
+		return;
+	TorrentEngine *engine = mEngine.get();
+	const lt::torrent_handle handle = *torrent->mHandle;
+	mEngine->post([engine, handle](lt::session &) {
+		TorrentEngine::Event event;
+		event.infoHash = handle.info_hash();
+		event.details.reset(new TorrentDetails());
+		// The torrent may have been removed in the meantime. libtorrent
+		// reports invalid handles only by exceptions.
+		try {
+			const lt::torrent_status status = handle.status(
+					lt::torrent_handle::query_pieces
+					| lt::torrent_handle::query_distributed_copies);
+			std::vector<lt::peer_info> peers;
+			handle.get_peer_info(peers);
+			event.details->loadFromLibtorrent(status, handle.trackers(), peers);
+		} catch (const lt::libtorrent_exception &) {
+			return;
+		}
+		engine->postEvent(std::move(event));
+	});
+}
+
+void TorrentSession::loadDetails(const lt::sha1_hash &infoHash,
+			std::unique_ptr<TorrentDetails> details)
+{
+	// Ignore details which arrive after the selection has changed.
+	Torrent *t = mTorrents.find(infoHash);
+	if (!t || t != mDetailedTorrent)
+		return;
+	t->mDetails = std::move(details);
+	t->detailsUpdated();
+}
 
-		delete alert;
+/**
+ * @brief Adds the torrents which were restored by the engine.
+ *
+ * The resume data lets libtorrent skip checking the files.
+ */
+void TorrentSession::resumeTorrents(std::vector<lt::add_torrent_params> &params)
+{
+	std::vector<lt::add_torrent_params> added;
+	added.reserve(params.size());
+	for (lt::add_torrent_params &p : params) {
+		const lt::sha1_hash infoHash = p.ti->info_hash();
+		if (mTorrents.find(infoHash))
+			continue;
+		// The resume data keeps the allocation the torrent was added with.
+		p.storage_mode = storageMode(DefaultAllocation);
+		p.flags = lt::add_torrent_params::flag_update_subscribe
+				| lt::add_torrent_params::flag_apply_ip_filter;
+		Torrent *t = mTorrents.insert(infoHash, std::unique_ptr<Torrent>(new Torrent(this)));
+		t->mMetadata.reset(new TorrentInfo(p.ti));
+		mResumingTorrents.insert(infoHash);
+		added.push_back(std::move(p));
 	}
+	mMetrics.resumedTorrents += added.size();
+	mEngine->post([added](lt::session &session) {
+		for (const lt::add_torrent_params &p : added) {
+			session.async_add_torrent(p);
+		}
+	});
+	mRefreshPolicy->wake();
+}
+
+//! Resolves TorrentSession::DefaultAllocation to the storage mode of libtorrent.
+lt::storage_mode_t TorrentSession::storageMode(Allocation allocation) const
+{
+	if (allocation == DefaultAllocation)
+		allocation = mDefaultAllocation;
+	switch (allocation) {
+	case FullAllocation: return lt::storage_mode_allocate;
+	default:             return lt::storage_mode_sparse;
+	}
+}
+
+//! Starts to measure the time until the torrent has downloaded its first byte.
+void TorrentSession::startDownloadTimer(const lt::sha1_hash &infoHash,
+			Allocation allocation)
+{
+	DownloadTimer &timer = mDownloadTimers[infoHash];
+	timer.full = storageMode(allocation) == lt::storage_mode_allocate;
+	timer.timer.start();
+}
+
+//! Records the time until the first byte for the allocation of the torrent.
+void TorrentSession::stopDownloadTimer(const lt::sha1_hash &infoHash)
+{
+	const auto it = mDownloadTimers.find(infoHash);
+	if (it == mDownloadTimers.end())
+		return;
+	const std::uint64_t elapsed = it->second.timer.elapsed();
+	if (it->second.full) {
+		++mMetrics.fullFirstByteTorrents;
+		mMetrics.fullFirstByteTimeSum += elapsed;
+	} else {
+		++mMetrics.sparseFirstByteTorrents;
+		mMetrics.sparseFirstByteTimeSum += elapsed;
+	}
+	mDownloadTimers.erase(it);
+}
+
+void TorrentSession::removeFromEngine(const lt::torrent_handle &handle, int options)
+{
+	mEngine->post([handle, options](lt::session &session) {
+		session.remove_torrent(handle, options);
+	});
+}
+
+void TorrentSession::streamInEngine(const lt::torrent_handle &handle, bool enabled)
+{
+	TorrentStreamer *streamer = mEngine->streamer();
+	mEngine->post([streamer, handle, enabled](lt::session &) {
+		streamer->setStreaming(handle, enabled);
+	});
+}
+
+void TorrentSession::onRefreshIntervalChanged(int interval)
+{
+	// Refresh immediately if the user is waiting for more recent data.
+	const bool sooner = interval < mStatusTimer->interval();
+	mStatusTimer->setInterval(interval);
+	if (sooner)
+		requestStatusUpdates();
+}
+
+void TorrentSession::watchAlertSubscriber(QObject *receiver)
+{
+	if (!mAlertSubscribers.contains(receiver)) {
+		mAlertSubscribers.insert(receiver);
+		connect(receiver, &QObject::destroyed,
+		        this, &TorrentSession::onAlertSubscriberDestroyed);
+	}
+}
+
+void TorrentSession::onAlertSubscriberDestroyed(QObject *receiver)
+{
+	mAlertRegistry.unsubscribe(receiver);
+	mAlertSubscribers.remove(receiver);
+}
+
+// Returns whether TorrentSession handles alerts of the given type itself.
+bool isSessionAlert(int type)
+{
+	switch (type) {
+	case lt::add_torrent_alert::alert_type:
+	case lt::torrent_added_alert::alert_type:
+	case lt::torrent_update_alert::alert_type:
+	case lt::torrent_removed_alert::alert_type:
+	case lt::torrent_deleted_alert::alert_type:
+	case lt::torrent_delete_failed_alert::alert_type:
+	case lt::metadata_received_alert::alert_type:
+	case lt::metadata_failed_alert::alert_type:
+	case lt::state_update_alert::alert_type:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Returns the info hash of the torrent the alert belongs to. The handle is not
+// valid anymore for some alerts. Use the info hash of the alert itself then.
+lt::sha1_hash infoHashOf(const lt::torrent_alert &alert)
+{
+	switch (alert.type()) {
+	case lt::add_torrent_alert::alert_type:
+	{
+		const lt::add_torrent_alert &a =
+				static_cast<const lt::add_torrent_alert&>(alert);
+		return a.params.ti ? a.params.ti->info_hash() : a.params.info_hash;
+	}
+	case lt::torrent_removed_alert::alert_type:
+		return static_cast<const lt::torrent_removed_alert&>(alert).info_hash;
+	case lt::torrent_deleted_alert::alert_type:
+		return static_cast<const lt::torrent_deleted_alert&>(alert).info_hash;
+	case lt::torrent_delete_failed_alert::alert_type:
+		return static_cast<const lt::torrent_delete_failed_alert&>(alert).info_hash;
+	default:
+		return alert.handle.info_hash();
+	}
+}
+
+// Returns whether the torrent transfers or checks data.
+bool isActive(const lt::torrent_status &status)
+{
+	if (status.download_payload_rate > 0 || status.upload_payload_rate > 0)
+		return true;
+	switch (status.state) {
+	case lt::torrent_status::seeding:
+	case lt::torrent_status::finished:
+		return false;
+	default:
+		return !status.paused;
+	}
+}
+
+// Returns whether the torrent has not finished checking its files yet.
+bool isChecking(const lt::torrent_status &status)
+{
+	switch (status.state) {
+	case lt::torrent_status::queued_for_checking:
+	case lt::torrent_status::checking_files:
+	case lt::torrent_status::checking_resume_data:
+		return true;
+	default:
+		return false;
+	}
+}
 
-	// get torrent states every 10 updates
-	if (++mNoUpdateCounter == 10) {
-		mSessionHandle->post_torrent_updates();
+// Returns how many bytes of the files of the torrent are not on the disk yet.
+// Files marked as shared with an older version are not counted.
+qint64 missingBytes(const lt::torrent_info &info, const QDir &saveDir,
+                    const std::vector<bool> &shared)
+{
+	const lt::file_storage &files = info.files();
+	qint64 missing = 0;
+	for (int i = 0; i < files.num_files(); ++i) {
+		if (files.pad_file_at(i) || (i < (int) shared.size() && shared[i]))
+			continue;
+		const QFileInfo file(saveDir.filePath(QString::fromStdString(files.file_path(i))));
+		missing += std::max<qint64>(files.file_size(i) - (file.exists() ? file.size() : 0), 0);
 	}
+	return missing;
 }
@@ -4,21 +4,41 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <set>
+#include <vector>
 
+#include <boost/intrusive_ptr.hpp>
+
+#include <libtorrent/storage_defs.hpp>
+
+#include <QElapsedTimer>
 #include <QObject>
+#include <QSet>
 #include <QVector>
 
+#include "torrentalertregistry.h"
+#include "torrentindex.h"
+#include "torrentnetworkpolicy.h"
+#include "torrentsessionmetrics.h"
+
 QT_BEGIN_NAMESPACE
 class QDir;
+class QThread;
+class QTimer;
 class QUrl;
 QT_END_NAMESPACE
 namespace libtorrent {
+struct add_torrent_params;
 class alert;
-class session;
 class sha1_hash;
+class torrent_handle;
 class torrent_info;
 }
 class Torrent;
+class TorrentDetails;
+class TorrentDiskSettings;
+class TorrentEngine;
+class TorrentRefreshPolicy;
 class TorrentSessionStatus;
 class TorrentsModel;
 
@@ -27,40 +47,149 @@ class TorrentSession : public QObject
 {
 	Q_OBJECT
 	Q_PROPERTY(const TorrentSessionStatus* status READ status)
+	Q_PROPERTY(AlertDelivery alertDelivery READ alertDelivery WRITE setAlertDelivery)
+	Q_PROPERTY(Profile profile READ profile WRITE setProfile)
+	Q_PROPERTY(Allocation defaultAllocation READ defaultAllocation WRITE setDefaultAllocation)
 
 public:
+	//! Defines how alerts of libtorrent reach the session.
+	enum AlertDelivery {
+		PollAlerts,  //!< Pop the alert queue periodically.
+		NotifyAlerts //!< Let libtorrent wake up the engine.
+	}; Q_ENUM(AlertDelivery)
+
+	//! Defines for which network the session is tuned.
+	enum Profile {
+		InternetProfile, //!< Use the defaults of libtorrent.
+		LanProfile       //!< Saturate fast local networks with trusted peers.
+	}; Q_ENUM(Profile)
+
+	//! Defines how the files of a torrent are allocated.
+	enum Allocation {
+		DefaultAllocation, //!< Use TorrentSession::defaultAllocation.
+		SparseAllocation,  //!< Create sparse files and write pieces when they
+		                   //!< arrive. The file system fills the gaps.
+		FullAllocation     //!< Reserve the files in full with fallocate or
+		                   //!< the equivalent of the platform.
+	}; Q_ENUM(Allocation)
+
 	explicit TorrentSession(QObject *parent = 0);
 	virtual ~TorrentSession();
 
 	const TorrentSessionStatus *status() const;
 	TorrentsModel *torrents() const;
 	QVector<Torrent*> getTorrentsAsVector() const;
+	TorrentSessionMetrics metrics() const;
+	void reportFirstFrame();
+	TorrentRefreshPolicy *refreshPolicy() const {return mRefreshPolicy;}
+
+	AlertDelivery alertDelivery() const {return mAlertDelivery;}
+	void setAlertDelivery(AlertDelivery delivery);
+
+	Profile profile() const {return mProfile;}
+	void setProfile(Profile profile);
+	Allocation defaultAllocation() const {return mDefaultAllocation;}
+	void setDefaultAllocation(Allocation allocation) {mDefaultAllocation = allocation;}
+	const TorrentNetworkPolicy &networkPolicy() const {return mNetworkPolicy;}
+	void setNetworkPolicy(const TorrentNetworkPolicy &policy);
+	void setDiskSettings(const TorrentDiskSettings &settings);
+
+	template<class Alert, class Receiver>
+	void subscribeAlert(Receiver *receiver,
+	                    void (Receiver::*handler)(const Alert&, Torrent*));
+	void unsubscribeAlerts(QObject *receiver);
+
+	Torrent *detailedTorrent() const {return mDetailedTorrent;}
 
 signals:
-	void alert(const libtorrent::alert &alert, Torrent *torrent);
 	void statusUpdated();
+	void torrentsUpdated(const QVector<Torrent*> &torrents);
 	void closed();
 
 public slots:
-	Torrent *addTorrent(const libtorrent::torrent_info &info,
-	                    const QDir &saveDir, std::uint64_t flags = 0);
+	Torrent *addTorrent(boost::intrusive_ptr<libtorrent::torrent_info> info,
+	                    const QDir &saveDir, std::uint64_t flags = 0,
+	                    Allocation allocation = DefaultAllocation);
+	QVector<Torrent*> addTorrents(
+			const std::vector<boost::intrusive_ptr<libtorrent::torrent_info>> &infos,
+			const QDir &saveDir, std::uint64_t flags = 0,
+			Allocation allocation = DefaultAllocation);
 	Torrent *addTorrentMagnet(const QUrl &uri, const QDir &saveDir,
-	                          std::uint64_t flags = 0);
+	                          std::uint64_t flags = 0,
+	                          Allocation allocation = DefaultAllocation);
 	void removeTorrent(Torrent *torrent);
 	void deleteTorrentFiles(Torrent *torrent);
+	void setStreaming(Torrent *torrent, bool enabled);
+	void setReadCursor(Torrent *torrent, int fileIndex, qint64 offset);
+	void setDetailedTorrent(Torrent *torrent);
 	void close();
 
 private slots:
 	void update();
+	void requestStatusUpdates();
+	void onAlertSubscriberDestroyed(QObject *receiver);
+	void onRefreshIntervalChanged(int interval);
 
 private:
-	std::unique_ptr<libtorrent::session> mSessionHandle;
-	std::map<libtorrent::sha1_hash,std::unique_ptr<Torrent>> mTorrentMap;
+	void removeFromEngine(const libtorrent::torrent_handle &handle, int options);
+	void streamInEngine(const libtorrent::torrent_handle &handle, bool enabled);
+	void watchAlertSubscriber(QObject *receiver);
+	void requestDetails(Torrent *torrent);
+	void loadDetails(const libtorrent::sha1_hash &infoHash,
+	                 std::unique_ptr<TorrentDetails> details);
+	void resumeTorrents(std::vector<libtorrent::add_torrent_params> &params);
+	libtorrent::storage_mode_t storageMode(Allocation allocation) const;
+	void startDownloadTimer(const libtorrent::sha1_hash &infoHash, Allocation allocation);
+	void stopDownloadTimer(const libtorrent::sha1_hash &infoHash);
+
+	std::unique_ptr<TorrentEngine> mEngine;
+	QThread *mEngineThread;
+	TorrentIndex mTorrents;
+	// Must be initialized before the model which subscribes to alerts.
+	TorrentAlertRegistry mAlertRegistry;
+	QSet<QObject*> mAlertSubscribers;
+	Torrent *mDetailedTorrent = nullptr;
 	TorrentSessionStatus *mStatus;
 	TorrentsModel *mModel;
 
-	int mNoUpdateCounter = 0;
+	AlertDelivery mAlertDelivery = PollAlerts;
+	Profile mProfile = InternetProfile;
+	Allocation mDefaultAllocation = SparseAllocation;
+	TorrentNetworkPolicy mNetworkPolicy;
+	QTimer *mStatusTimer;
+	TorrentRefreshPolicy *mRefreshPolicy;
+	TorrentSessionMetrics mMetrics;
+	// Resumed torrents which have not finished checking their resume data.
+	std::set<libtorrent::sha1_hash> mResumingTorrents;
+	QElapsedTimer mStartupTimer;
+	// Added torrents which have not downloaded anything yet.
+	struct DownloadTimer {
+		bool full = false;
+		QElapsedTimer timer;
+	};
+	std::map<libtorrent::sha1_hash, DownloadTimer> mDownloadTimers;
 
 };
 
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Subscribes to alerts of the type Alert.
+ *
+ * The handler is called for every alert of this type. For alerts derived from
+ * libtorrent::torrent_alert, the second argument is the affected torrent. The
+ * subscription ends when the receiver is destroyed or
+ * TorrentSession::unsubscribeAlerts is called.
+ *
+ * @param receiver The object which handles the alerts.
+ * @param handler The member function of the receiver to call.
+ */
+template<class Alert, class Receiver>
+void TorrentSession::subscribeAlert(Receiver *receiver,
+			void (Receiver::*handler)(const Alert&, Torrent*))
+{
+	watchAlertSubscriber(receiver);
+	mAlertRegistry.subscribe(receiver, handler);
+}
+
 #endif // TORRENTSESSION_H
@@ -0,0 +1,108 @@
+#ifndef TORRENTSESSIONMETRICS_H
+#define TORRENTSESSIONMETRICS_H
+
+#include <cstdint>
+
+
+//! Counters which TorrentSession collects about its own overhead.
+struct TorrentSessionMetrics
+{
+	//! Number of times the alert queue was drained.
+	std::uint64_t alertTicks = 0;
+	//! Number of drains which did not find any alert.
+	std::uint64_t idleAlertTicks = 0;
+	//! Number of handled alerts.
+	std::uint64_t alerts = 0;
+	//! Sum of the time between posting and handling of all alerts in µs.
+	std::uint64_t alertLatencySum = 0;
+	//! Highest time between posting and handling of a single alert in µs.
+	std::uint64_t alertLatencyMax = 0;
+	//! Number of status requests per level of TorrentRefreshPolicy.
+	std::uint64_t fastStatusRequests = 0;
+	std::uint64_t normalStatusRequests = 0;
+	std::uint64_t hiddenStatusRequests = 0;
+	std::uint64_t dormantStatusRequests = 0;
+	//! Number of times the status interval has changed.
+	std::uint64_t statusIntervalChanges = 0;
+	//! Current status interval in ms.
+	int statusInterval = 0;
+	//! Number of torrents restored from resume data.
+	std::uint64_t resumedTorrents = 0;
+	//! Time from the start of the session until the main window was painted
+	//! for the first time in ms, or -1 if not reached yet.
+	std::int64_t startupToFirstFrameTime = -1;
+	//! Time from the start of the session until all resumed torrents have
+	//! checked their resume data in ms, or -1 if not reached yet.
+	std::int64_t startupToSeedingTime = -1;
+	//! Number of resume files written or removed.
+	std::uint64_t resumeWrites = 0;
+	//! Number of batches the resume files were written in.
+	std::uint64_t resumeBatches = 0;
+	//! Number of torrents with metadata.
+	std::uint64_t metadataTorrents = 0;
+	//! Estimated memory used by the metadata of all torrents in bytes. The
+	//! metadata is shared with libtorrent, so this is also what a separate
+	//! copy for the GUI would cost.
+	std::uint64_t metadataBytes = 0;
+	//! Number of added torrents which have downloaded their first byte per
+	//! allocation.
+	std::uint64_t sparseFirstByteTorrents = 0;
+	std::uint64_t fullFirstByteTorrents = 0;
+	//! Sum of the time from adding a torrent until its first downloaded byte
+	//! per allocation in ms.
+	std::uint64_t sparseFirstByteTimeSum = 0;
+	std::uint64_t fullFirstByteTimeSum = 0;
+	//! Number of streams which have downloaded their first bytes and the sum
+	//! of the time it took in ms.
+	std::uint64_t streamFirstBytes = 0;
+	std::uint64_t streamFirstBytesTimeSum = 0;
+	//! Number, payload and active time in s of finished streamed torrents.
+	std::uint64_t streamedTorrents = 0;
+	std::uint64_t streamedBytes = 0;
+	std::uint64_t streamedTime = 0;
+	//! Number, payload and active time in s of finished other torrents.
+	std::uint64_t downloadedTorrents = 0;
+	std::uint64_t downloadedBytes = 0;
+	std::uint64_t downloadedTime = 0;
+
+	//! Average time between posting and handling of an alert in µs.
+	double averageAlertLatency() const
+	{
+		return alerts ? (double) alertLatencySum / alerts : 0.0;
+	}
+
+	//! Memory saved per torrent by sharing the metadata in bytes.
+	double metadataBytesSavedPerTorrent() const
+	{
+		return metadataTorrents ? (double) metadataBytes / metadataTorrents : 0.0;
+	}
+	//! Average time until the first byte with sparse files in ms.
+	double averageSparseFirstByteTime() const
+	{
+		return sparseFirstByteTorrents
+				? (double) sparseFirstByteTimeSum / sparseFirstByteTorrents : 0.0;
+	}
+	//! Average time until the first byte with allocated files in ms.
+	double averageFullFirstByteTime() const
+	{
+		return fullFirstByteTorrents
+				? (double) fullFirstByteTimeSum / fullFirstByteTorrents : 0.0;
+	}
+	//! Average time until a stream has its first bytes in ms.
+	double averageStreamFirstBytesTime() const
+	{
+		return streamFirstBytes ? (double) streamFirstBytesTimeSum / streamFirstBytes : 0.0;
+	}
+	//! Download rate of streamed torrents in bytes/s.
+	double streamedThroughput() const
+	{
+		return streamedTime ? (double) streamedBytes / streamedTime : 0.0;
+	}
+	//! Download rate of other torrents in bytes/s.
+	double downloadedThroughput() const
+	{
+		return downloadedTime ? (double) downloadedBytes / downloadedTime : 0.0;
+	}
+};
+
+#endif // TORRENTSESSIONMETRICS_H
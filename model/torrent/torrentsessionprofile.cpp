@@ -0,0 +1,77 @@
+#include "torrentsessionprofile.h"
+
+#include <libtorrent/session_settings.hpp>
+
+namespace lt = libtorrent;
+
+// Limits of the LAN profile.
+static const int LAN_CONNECTIONS_LIMIT = 2000;
+static const int LAN_UNCHOKE_SLOTS_LIMIT = 200;
+static const int LAN_SEND_BUFFER_WATERMARK = 8 * 1024 * 1024;
+static const int LAN_SEND_BUFFER_LOW_WATERMARK = 1024 * 1024;
+static const int LAN_SEND_BUFFER_WATERMARK_FACTOR = 150;
+static const int LAN_SOCKET_BUFFER_SIZE = 4 * 1024 * 1024;
+static const int LAN_MAX_OUT_REQUEST_QUEUE = 1500;
+static const int LAN_MAX_IN_REQUEST_QUEUE = 2000;
+// Peers on the LAN are found by local service discovery only.
+static const int LAN_SERVICE_ANNOUNCE_INTERVAL = 60;
+
+
+//! Sets the fields of the session settings which belong to the profile.
+void TorrentSessionProfile::apply(TorrentSession::Profile profile,
+			lt::session_settings &settings)
+{
+	// Start with the defaults of libtorrent which are tuned for the internet.
+	const lt::session_settings defaults;
+	settings.connections_limit = defaults.connections_limit;
+	settings.unchoke_slots_limit = defaults.unchoke_slots_limit;
+	settings.choking_algorithm = defaults.choking_algorithm;
+	settings.seed_choking_algorithm = defaults.seed_choking_algorithm;
+	settings.send_buffer_watermark = defaults.send_buffer_watermark;
+	settings.send_buffer_low_watermark = defaults.send_buffer_low_watermark;
+	settings.send_buffer_watermark_factor = defaults.send_buffer_watermark_factor;
+	settings.recv_socket_buffer_size = defaults.recv_socket_buffer_size;
+	settings.send_socket_buffer_size = defaults.send_socket_buffer_size;
+	settings.max_out_request_queue = defaults.max_out_request_queue;
+	settings.max_allowed_in_request_queue = defaults.max_allowed_in_request_queue;
+	settings.mixed_mode_algorithm = defaults.mixed_mode_algorithm;
+	settings.enable_outgoing_utp = defaults.enable_outgoing_utp;
+	settings.enable_incoming_utp = defaults.enable_incoming_utp;
+	settings.local_service_announce_interval = defaults.local_service_announce_interval;
+	if (profile != TorrentSession::LanProfile)
+		return;
+
+	settings.connections_limit = LAN_CONNECTIONS_LIMIT;
+	settings.unchoke_slots_limit = LAN_UNCHOKE_SLOTS_LIMIT;
+	// Unchoke as many peers as the upload rate allows.
+	settings.choking_algorithm = lt::session_settings::rate_based_choker;
+	settings.seed_choking_algorithm = lt::session_settings::fastest_upload;
+	// Keep enough data queued to fill links with a large bandwidth.
+	settings.send_buffer_watermark = LAN_SEND_BUFFER_WATERMARK;
+	settings.send_buffer_low_watermark = LAN_SEND_BUFFER_LOW_WATERMARK;
+	settings.send_buffer_watermark_factor = LAN_SEND_BUFFER_WATERMARK_FACTOR;
+	settings.recv_socket_buffer_size = LAN_SOCKET_BUFFER_SIZE;
+	settings.send_socket_buffer_size = LAN_SOCKET_BUFFER_SIZE;
+	settings.max_out_request_queue = LAN_MAX_OUT_REQUEST_QUEUE;
+	settings.max_allowed_in_request_queue = LAN_MAX_IN_REQUEST_QUEUE;
+	// uTP yields to other traffic and cannot saturate the LAN.
+	settings.mixed_mode_algorithm = lt::session_settings::prefer_tcp;
+	settings.enable_outgoing_utp = false;
+	settings.enable_incoming_utp = false;
+	settings.local_service_announce_interval = LAN_SERVICE_ANNOUNCE_INTERVAL;
+}
+
+//! Sets the encryption policy of the profile.
+void TorrentSessionProfile::apply(TorrentSession::Profile profile,
+			lt::pe_settings &encryption)
+{
+	if (profile == TorrentSession::LanProfile) {
+		// Peers on the LAN are trusted and encryption costs CPU time.
+		encryption.out_enc_policy = lt::pe_settings::disabled;
+		encryption.in_enc_policy = lt::pe_settings::disabled;
+		encryption.allowed_enc_level = lt::pe_settings::plaintext;
+		encryption.prefer_rc4 = false;
+	} else {
+		encryption = lt::pe_settings();
+	}
+}
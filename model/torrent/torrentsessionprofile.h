@@ -0,0 +1,36 @@
+#ifndef TORRENTSESSIONPROFILE_H
+#define TORRENTSESSIONPROFILE_H
+
+#include "torrentsession.h"
+
+namespace libtorrent {
+struct pe_settings;
+struct session_settings;
+}
+
+
+/**
+ * @brief Maps a TorrentSession::Profile to the settings of libtorrent.
+ *
+ * The internet profile uses the defaults of libtorrent. The LAN profile
+ * assumes a fast network with low latency and trusted peers. It allows many
+ * connections and unchokes peers by their rate, uses large buffers to keep
+ * gigabit links busy, prefers TCP over the delay-based congestion control of
+ * uTP and does not encrypt connections.
+ *
+ * Settings which are not part of a profile are left unchanged.
+ */
+class TorrentSessionProfile
+{
+public:
+	static void apply(TorrentSession::Profile profile,
+	                  libtorrent::session_settings &settings);
+	static void apply(TorrentSession::Profile profile,
+	                  libtorrent::pe_settings &encryption);
+
+private:
+	TorrentSessionProfile() = delete;
+
+};
+
+#endif // TORRENTSESSIONPROFILE_H
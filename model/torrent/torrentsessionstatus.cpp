@@ -1,10 +1,32 @@
 #include "torrentsessionstatus.h"
 
+#include <libtorrent/disk_io_thread.hpp>
 #include <libtorrent/session_status.hpp>
+#include <libtorrent/version.hpp>
+
+#include "torrentnetworkpolicy.h"
 
 
 TorrentSessionStatus::TorrentSessionStatus(QObject *parent) :
-	QObject(parent)
+	QObject(parent),
+	mNumPeers(0),
+	mDownloadRate(0),
+	mUploadRate(0),
+	mPayloadDownloadRate(0),
+	mPayloadUploadRate(0),
+	mTotalDownload(0),
+	mTotalUpload(0),
+	mTotalPayloadDownload(0),
+	mTotalPayloadUpload(0),
+	mLanPeers(0),
+	mLanDownloadRate(0),
+	mLanUploadRate(0),
+	mWanPeers(0),
+	mWanDownloadRate(0),
+	mWanUploadRate(0),
+	mDiskCacheHitRatio(0),
+	mDiskQueueDepth(0),
+	mDiskQueuedBytes(0)
 {
 }
 
@@ -57,6 +79,51 @@ double TorrentSessionStatus::totalPayloadUpload() const
 	return mTotalPayloadUpload;
 }
 
+int TorrentSessionStatus::lanPeers() const
+{
+	return mLanPeers;
+}
+
+int TorrentSessionStatus::lanDownloadRate() const
+{
+	return mLanDownloadRate;
+}
+
+int TorrentSessionStatus::lanUploadRate() const
+{
+	return mLanUploadRate;
+}
+
+int TorrentSessionStatus::wanPeers() const
+{
+	return mWanPeers;
+}
+
+int TorrentSessionStatus::wanDownloadRate() const
+{
+	return mWanDownloadRate;
+}
+
+int TorrentSessionStatus::wanUploadRate() const
+{
+	return mWanUploadRate;
+}
+
+double TorrentSessionStatus::diskCacheHitRatio() const
+{
+	return mDiskCacheHitRatio;
+}
+
+int TorrentSessionStatus::diskQueueDepth() const
+{
+	return mDiskQueueDepth;
+}
+
+double TorrentSessionStatus::diskQueuedBytes() const
+{
+	return mDiskQueuedBytes;
+}
+
 void TorrentSessionStatus::setNumPeers(int numPeers)
 {
 	if (mNumPeers != numPeers) {
@@ -129,6 +196,78 @@ void TorrentSessionStatus::setTotalPayloadUpload(double totalPayloadUpload)
 	}
 }
 
+void TorrentSessionStatus::setLanPeers(int lanPeers)
+{
+	if (mLanPeers != lanPeers) {
+		mLanPeers = lanPeers;
+		lanPeersChanged();
+	}
+}
+
+void TorrentSessionStatus::setLanDownloadRate(int lanDownloadRate)
+{
+	if (mLanDownloadRate != lanDownloadRate) {
+		mLanDownloadRate = lanDownloadRate;
+		lanDownloadRateChanged();
+	}
+}
+
+void TorrentSessionStatus::setLanUploadRate(int lanUploadRate)
+{
+	if (mLanUploadRate != lanUploadRate) {
+		mLanUploadRate = lanUploadRate;
+		lanUploadRateChanged();
+	}
+}
+
+void TorrentSessionStatus::setWanPeers(int wanPeers)
+{
+	if (mWanPeers != wanPeers) {
+		mWanPeers = wanPeers;
+		wanPeersChanged();
+	}
+}
+
+void TorrentSessionStatus::setWanDownloadRate(int wanDownloadRate)
+{
+	if (mWanDownloadRate != wanDownloadRate) {
+		mWanDownloadRate = wanDownloadRate;
+		wanDownloadRateChanged();
+	}
+}
+
+void TorrentSessionStatus::setWanUploadRate(int wanUploadRate)
+{
+	if (mWanUploadRate != wanUploadRate) {
+		mWanUploadRate = wanUploadRate;
+		wanUploadRateChanged();
+	}
+}
+
+void TorrentSessionStatus::setDiskCacheHitRatio(double diskCacheHitRatio)
+{
+	if (mDiskCacheHitRatio != diskCacheHitRatio) {
+		mDiskCacheHitRatio = diskCacheHitRatio;
+		diskCacheHitRatioChanged();
+	}
+}
+
+void TorrentSessionStatus::setDiskQueueDepth(int diskQueueDepth)
+{
+	if (mDiskQueueDepth != diskQueueDepth) {
+		mDiskQueueDepth = diskQueueDepth;
+		diskQueueDepthChanged();
+	}
+}
+
+void TorrentSessionStatus::setDiskQueuedBytes(double diskQueuedBytes)
+{
+	if (mDiskQueuedBytes != diskQueuedBytes) {
+		mDiskQueuedBytes = diskQueuedBytes;
+		diskQueuedBytesChanged();
+	}
+}
+
 void TorrentSessionStatus::loadFromLibtorrent(const libtorrent::session_status &status)
 {
 	setNumPeers(status.num_peers);
@@ -141,3 +280,31 @@ void TorrentSessionStatus::loadFromLibtorrent(const libtorrent::session_status &
 	setTotalPayloadDownload(status.total_payload_download);
 	setTotalPayloadUpload(status.total_payload_upload);
 }
+
+void TorrentSessionStatus::loadNetworkTraffic(const TorrentNetworkTraffic &traffic)
+{
+	setLanPeers(traffic.lanPeers);
+	setLanDownloadRate(traffic.lanDownloadRate);
+	setLanUploadRate(traffic.lanUploadRate);
+	setWanPeers(traffic.wanPeers);
+	setWanDownloadRate(traffic.wanDownloadRate);
+	setWanUploadRate(traffic.wanUploadRate);
+}
+
+/**
+ * @brief Loads the counters of the disk cache.
+ *
+ * The hit ratio is the share of all blocks read from the cache since the
+ * session started. The queue depth is the number of disk jobs waiting.
+ */
+void TorrentSessionStatus::loadCacheStatus(const libtorrent::cache_status &status)
+{
+	setDiskCacheHitRatio(status.blocks_read > 0
+	                     ? (double) status.blocks_read_hit / status.blocks_read : 0.0);
+#if LIBTORRENT_VERSION_NUM >= 10100
+	setDiskQueueDepth(status.queued_jobs);
+#else
+	setDiskQueueDepth(status.job_queue_length);
+#endif
+	setDiskQueuedBytes(status.queued_bytes);
+}
@@ -4,8 +4,10 @@
 #include <QObject>
 
 namespace libtorrent {
+struct cache_status;
 struct session_status;
 }
+struct TorrentNetworkTraffic;
 
 
 class TorrentSessionStatus : public QObject
@@ -29,6 +31,24 @@ class TorrentSessionStatus : public QObject
 	           WRITE setTotalPayloadDownload NOTIFY totalPayloadDownloadChanged)
 	Q_PROPERTY(double totalPayloadUpload     READ totalPayloadUpload
 	           WRITE setTotalPayloadUpload   NOTIFY totalPayloadUploadChanged)
+	Q_PROPERTY(int    lanPeers               READ lanPeers
+	           WRITE setLanPeers             NOTIFY lanPeersChanged)
+	Q_PROPERTY(int    lanDownloadRate        READ lanDownloadRate
+	           WRITE setLanDownloadRate      NOTIFY lanDownloadRateChanged)
+	Q_PROPERTY(int    lanUploadRate          READ lanUploadRate
+	           WRITE setLanUploadRate        NOTIFY lanUploadRateChanged)
+	Q_PROPERTY(int    wanPeers               READ wanPeers
+	           WRITE setWanPeers             NOTIFY wanPeersChanged)
+	Q_PROPERTY(int    wanDownloadRate        READ wanDownloadRate
+	           WRITE setWanDownloadRate      NOTIFY wanDownloadRateChanged)
+	Q_PROPERTY(int    wanUploadRate          READ wanUploadRate
+	           WRITE setWanUploadRate        NOTIFY wanUploadRateChanged)
+	Q_PROPERTY(double diskCacheHitRatio      READ diskCacheHitRatio
+	           WRITE setDiskCacheHitRatio    NOTIFY diskCacheHitRatioChanged)
+	Q_PROPERTY(int    diskQueueDepth         READ diskQueueDepth
+	           WRITE setDiskQueueDepth       NOTIFY diskQueueDepthChanged)
+	Q_PROPERTY(double diskQueuedBytes        READ diskQueuedBytes
+	           WRITE setDiskQueuedBytes      NOTIFY diskQueuedBytesChanged)
 
 public:
 	explicit TorrentSessionStatus(QObject *parent = 0);
@@ -43,6 +63,15 @@ public:
 	double totalUpload() const;
 	double totalPayloadDownload() const;
 	double totalPayloadUpload() const;
+	int lanPeers() const;
+	int lanDownloadRate() const;
+	int lanUploadRate() const;
+	int wanPeers() const;
+	int wanDownloadRate() const;
+	int wanUploadRate() const;
+	double diskCacheHitRatio() const;
+	int diskQueueDepth() const;
+	double diskQueuedBytes() const;
 
 	void setNumPeers(int numPeers);
 	void setDownloadRate(int downloadRate);
@@ -53,8 +82,19 @@ public:
 	void setTotalUpload(double totalUpload);
 	void setTotalPayloadDownload(double totalPayloadDownload);
 	void setTotalPayloadUpload(double totalPayloadUpload);
+	void setLanPeers(int lanPeers);
+	void setLanDownloadRate(int lanDownloadRate);
+	void setLanUploadRate(int lanUploadRate);
+	void setWanPeers(int wanPeers);
+	void setWanDownloadRate(int wanDownloadRate);
+	void setWanUploadRate(int wanUploadRate);
+	void setDiskCacheHitRatio(double diskCacheHitRatio);
+	void setDiskQueueDepth(int diskQueueDepth);
+	void setDiskQueuedBytes(double diskQueuedBytes);
 
 	void loadFromLibtorrent(const libtorrent::session_status &status);
+	void loadNetworkTraffic(const TorrentNetworkTraffic &traffic);
+	void loadCacheStatus(const libtorrent::cache_status &status);
 
 signals:
 	void numPeersChanged();
@@ -66,6 +106,15 @@ signals:
 	void totalUploadChanged();
 	void totalPayloadDownloadChanged();
 	void totalPayloadUploadChanged();
+	void lanPeersChanged();
+	void lanDownloadRateChanged();
+	void lanUploadRateChanged();
+	void wanPeersChanged();
+	void wanDownloadRateChanged();
+	void wanUploadRateChanged();
+	void diskCacheHitRatioChanged();
+	void diskQueueDepthChanged();
+	void diskQueuedBytesChanged();
 
 private:
 	int mNumPeers;
@@ -77,6 +126,15 @@ private:
 	double mTotalUpload;
 	double mTotalPayloadDownload;
 	double mTotalPayloadUpload;
+	int mLanPeers;
+	int mLanDownloadRate;
+	int mLanUploadRate;
+	int mWanPeers;
+	int mWanDownloadRate;
+	int mWanUploadRate;
+	double mDiskCacheHitRatio;
+	int mDiskQueueDepth;
+	double mDiskQueuedBytes;
 
 };
 
@@ -25,15 +25,15 @@ TorrentsModel::TorrentsModel(TorrentSession *session, QObject *parent)
 {
 	// Add added torrents of the session to the model.
 	for (Torrent *torrent : session->getTorrentsAsVector()) {
-		if (torrent->wasAdded()) {
-			trackTorrent(torrent);
-			mDownloads->trackTorrent(torrent);
-			mUploads->trackTorrent(torrent);
-		}
+		if (torrent->wasAdded())
+			mAddedTorrents.push_back(torrent);
 	}
+	trackAddedTorrents();
 	// Connect to session stay up to date.
-	connect(session, &TorrentSession::alert,
-	        this, &TorrentsModel::onAlert);
+	session->subscribeAlert(this, &TorrentsModel::onTorrentAdded);
+	session->subscribeAlert(this, &TorrentsModel::onTorrentRemoved);
+	connect(session, &TorrentSession::torrentsUpdated,
+	        this, &TorrentsModel::onTorrentsUpdated);
 }
 
 int TorrentsModel::compareTorrents(Torrent *, Torrent *) const
@@ -46,40 +46,50 @@ int TorrentsModel::validateTorrent(Torrent *) const
 	return AcceptTorrent;
 }
 
-void TorrentsModel::onAlert(const libtorrent::alert &alert, Torrent *torrent)
+void TorrentsModel::onTorrentsUpdated(const QVector<Torrent*> &torrents)
 {
-	switch (alert.type()) {
-	case lt::torrent_added_alert::alert_type:
-	{
-		assert(torrent);
-//		const lt::torrent_added_alert &a =
-//				static_cast<const lt::torrent_added_alert&>(alert);
-
-		trackTorrent(torrent);
-		mDownloads->trackTorrent(torrent);
-		mUploads->trackTorrent(torrent);
-		break;
-	}
-	case lt::torrent_removed_alert::alert_type:
-	{
-		assert(torrent);
-//		const lt::torrent_removed_alert &a =
-//				static_cast<const lt::torrent_removed_alert&>(alert);
-
-		mUploads->untrackTorrent(torrent);
-		mDownloads->untrackTorrent(torrent);
-		untrackTorrent(torrent);
-		break;
-	}
-	}
+	updateTorrents(torrents);
+	mDownloads->updateTorrents(torrents);
+	mUploads->updateTorrents(torrents);
+}
+
+void TorrentsModel::onTorrentAdded(const lt::torrent_added_alert &,
+			Torrent *torrent)
+{
+	assert(torrent);
+	// Insert all torrents added by the same burst of alerts at once, e.g. when
+	// the session is restored.
+	if (mAddedTorrents.isEmpty())
+		QMetaObject::invokeMethod(this, "trackAddedTorrents", Qt::QueuedConnection);
+	mAddedTorrents.push_back(torrent);
+}
+
+void TorrentsModel::trackAddedTorrents()
+{
+	const QVector<Torrent*> added = std::move(mAddedTorrents);
+	mAddedTorrents.clear();
+	trackTorrents(added);
+	mDownloads->trackTorrents(added);
+	mUploads->trackTorrents(added);
+}
+
+void TorrentsModel::onTorrentRemoved(const lt::torrent_removed_alert &,
+			Torrent *torrent)
+{
+	assert(torrent);
+	if (mAddedTorrents.removeOne(torrent))
+		return;
+	mUploads->untrackTorrent(torrent);
+	mDownloads->untrackTorrent(torrent);
+	untrackTorrent(torrent);
 }
 
 DownloadsModel::DownloadsModel(QObject *parent)
 	: TorrentsModelBase(parent)
 	, mFinished(0)
 {
-	connect(this, &DownloadsModel::torrentUpdated,
-	        this, &DownloadsModel::onTorrentUpdated);
+	connect(this, &DownloadsModel::torrentsUpdated,
+	        this, &DownloadsModel::onTorrentsUpdated);
 }
 
 int DownloadsModel::compareTorrents(Torrent *t1, Torrent *t2) const
@@ -100,7 +110,7 @@ int DownloadsModel::validateTorrent(Torrent *torrent) const
 	}
 }
 
-void DownloadsModel::onTorrentUpdated()
+void DownloadsModel::onTorrentsUpdated()
 {
 	// TODO Update mFinished.
 }
@@ -1,10 +1,13 @@
 #ifndef TORRENTSMODEL_H
 #define TORRENTSMODEL_H
 
-#include <libtorrent/alert.hpp>
-
 #include "torrentsmodelbase.h"
 
+namespace libtorrent {
+struct torrent_added_alert;
+struct torrent_removed_alert;
+}
+
 class Torrent;
 class TorrentSession;
 
@@ -23,7 +26,7 @@ protected:
 	int validateTorrent(Torrent *) const override;
 
 private slots:
-	void onTorrentUpdated();
+	void onTorrentsUpdated();
 
 private:
 	explicit DownloadsModel(QObject *parent = 0);
@@ -69,11 +72,20 @@ protected:
 	int validateTorrent(Torrent *) const override;
 
 private slots:
-	void onAlert(const libtorrent::alert &alert, Torrent *torrent);
+	void onTorrentsUpdated(const QVector<Torrent*> &torrents);
+	void trackAddedTorrents();
 
 private:
+	void onTorrentAdded(const libtorrent::torrent_added_alert &alert,
+	                    Torrent *torrent);
+	void onTorrentRemoved(const libtorrent::torrent_removed_alert &alert,
+	                      Torrent *torrent);
+
 	DownloadsModel *mDownloads;
 	UploadsModel *mUploads;
+	// Added torrents which are inserted together when control returns to the
+	// event loop.
+	QVector<Torrent*> mAddedTorrents;
 
 };
 
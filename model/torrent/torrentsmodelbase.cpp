@@ -1,31 +1,38 @@
 #include "torrentsmodelbase.h"
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include <QMetaEnum>
+#include <QPersistentModelIndex>
 
 #include "torrent.h"
 #include "torrentinfo.h"
 
+// Maximum number of torrents which are moved one by one to restore the order.
+// The whole model is sorted within a single layout change if more are out of
+// order.
+static const int MAX_SORT_MOVES = 16;
+
 
 TorrentsModelBase::TorrentsModelBase(QObject *parent)
 	: QAbstractListModel(parent)
 {
 }
 
+//! Returns the row of the torrent or -1 if it is not part of the model.
 int TorrentsModelBase::rowFromTorrent(const Torrent *torrent) const
 {
-	auto it = mTorrentMap.find(torrent);
-	assert(it != mTorrentMap.end());
-	return it->second;
+	return mTorrents.indexOf(const_cast<Torrent*>(torrent));
 }
 
 Torrent *TorrentsModelBase::torrentFromRow(int row) const
 {
-	if (row >= 0 && row < mTorrentList.length())
+	if (row < 0 || row >= mTorrents.size())
 		return nullptr;
 	else
-		return mTorrentList[row];
+		return mTorrents.at(row);
 }
 
 int TorrentsModelBase::rowCount(const QModelIndex &parent) const
@@ -33,17 +40,17 @@ int TorrentsModelBase::rowCount(const QModelIndex &parent) const
 	if (parent.isValid())
 		return 0;
 	else
-		return mTorrentList.size();
+		return mTorrents.size();
 }
 
 QVariant TorrentsModelBase::data(const QModelIndex &index, int role) const
 {
 	if (!index.isValid())
 		return QVariant();
-	if (index.row() >= mTorrentList.size())
+	if (index.row() >= mTorrents.size())
 		return QVariant();
 
-	Torrent *t = mTorrentList[index.row()];
+	Torrent *t = mTorrents.at(index.row());
 	switch (role) {
 	case TorrentRole:     return QVariant::fromValue(t);
 	case Qt::DisplayRole: return t->metadata() ? t->metadata()->name()    : QVariant();
@@ -61,149 +68,265 @@ QHash<int, QByteArray> TorrentsModelBase::roleNames() const
 
 void TorrentsModelBase::trackTorrent(Torrent *torrent)
 {
-	// Ensure that you are not adding torrents which are already in the model.
-	assert(mTorrentMap.find(torrent) == mTorrentMap.end());
-	// Register handlers to stay up to date. Even if we do not add the torrent.
-	// Maybe we want add it later.
-	registerHandler(torrent);
-	// Check if we should add the torrent to the model.
-	if (validateTorrent(torrent) == AcceptTorrent)
-		addTorrent(torrent);
+	trackTorrents(QVector<Torrent*>{torrent});
+}
+
+/**
+ * @brief Starts to track multiple torrents at once.
+ *
+ * Many torrents are inserted into the model with a single row insertion.
+ *
+ * @param torrents The torrents which are not tracked yet.
+ */
+void TorrentsModelBase::trackTorrents(const QVector<Torrent*> &torrents)
+{
+	QVector<Torrent*> accepted;
+	accepted.reserve(torrents.size());
+	for (Torrent *torrent : torrents) {
+		// Ensure that you are not adding torrents which are already in the model.
+		assert(!mTorrents.contains(torrent));
+		// Remember the torrent to stay up to date. Even if we do not add the
+		// torrent. Maybe we want add it later.
+		mTrackedTorrents.insert(torrent);
+		registerHandler(torrent);
+		// Check if we should add the torrent to the model.
+		if (validateTorrent(torrent) == AcceptTorrent)
+			accepted.push_back(torrent);
+	}
+	addTorrents(accepted);
 }
 
 void TorrentsModelBase::untrackTorrent(Torrent *torrent)
 {
 	// Unregister handler.
 	unregisterHandler(torrent);
+	mTrackedTorrents.erase(torrent);
 	removeTorrent(torrent);
 }
 
-void TorrentsModelBase::onTorrentMetadataUpdated()
+/**
+ * @brief Handles a status update of multiple torrents at once.
+ *
+ * Torrents are added or removed according to TorrentsModelBase::validateTorrent.
+ * The model is sorted at most once and TorrentsModelBase::torrentsUpdated is
+ * emitted once for all updated torrents which stay in the model.
+ *
+ * @param torrents The updated torrents. Torrents which are not tracked by this
+ *        model are ignored.
+ */
+void TorrentsModelBase::updateTorrents(const QVector<Torrent*> &torrents)
 {
-	// Get the updated torrent.
-	assert(dynamic_cast<Torrent*>(sender()));
-	Torrent *t = static_cast<Torrent*>(sender());
-	// Handle update.
-	handleTorrentUpdate(t, true);
+	QVector<Torrent*> updated;
+	QVector<Torrent*> added;
+	updated.reserve(torrents.size());
+	// Remove torrents which do not belong to the model anymore and collect
+	// the others.
+	for (Torrent *torrent : torrents) {
+		if (mTrackedTorrents.find(torrent) == mTrackedTorrents.end())
+			continue;
+		const int validation = validateTorrent(torrent);
+		if (!mTorrents.contains(torrent)) {
+			if (validation == AcceptTorrent)
+				added.push_back(torrent);
+		} else if (validation == RemoveTorrent) {
+			removeTorrent(torrent);
+		} else {
+			updated.push_back(torrent);
+		}
+	}
+	// Restore the order before adding new torrents since they are inserted
+	// at their sorted position.
+	sortTorrents(updated);
+	addTorrents(added);
+	// Propagate changes.
+	if (!updated.isEmpty())
+		torrentsUpdated(updated);
 }
 
-void TorrentsModelBase::onTorrentStatusUpdated()
+void TorrentsModelBase::onTorrentMetadataUpdated()
 {
 	// Get the updated torrent.
 	assert(dynamic_cast<Torrent*>(sender()));
 	Torrent *t = static_cast<Torrent*>(sender());
 	// Handle update.
-	handleTorrentUpdate(t, false);
+	updateTorrents(QVector<Torrent*>{t});
+	// Emit signal to propagate changes of the name and comment.
+	const int row = mTorrents.indexOf(t);
+	if (row >= 0) {
+		dataChanged(index(row, 0), index(row, 0), {Qt::DisplayRole, Qt::ToolTipRole});
+	}
 }
 
 void TorrentsModelBase::addTorrent(Torrent *torrent)
 {
 	// Find row where the torrent should be inserted.
-	int row = mTorrentList.size();
-	while (row > 0 && compareTorrents(mTorrentList[row - 1], torrent) > 0)
-		--row;
+	const int row = mTorrents.upperBound(torrent, [this](Torrent *t1, Torrent *t2) {
+		return compareTorrents(t1, t2) < 0;
+	});
 	// Inform listeners that we will add a torrent.
 	beginInsertRows(QModelIndex(), row, row);
-	// Remove the torrent to the list.
-	mTorrentList.insert(row, torrent);
-	// Update the map.
-	mTorrentMap.emplace(torrent, row);
-	updateRowNumbers(row + 1, +1);
+	// Add the torrent to the list.
+	mTorrents.insert(row, torrent);
 	// Inform listeners that we have finished the process.
 	lengthChanged();
 	endInsertRows();
 }
 
+/**
+ * @brief Adds multiple torrents to the model.
+ *
+ * A few torrents are inserted at their sorted rows one by one. Otherwise, all
+ * torrents are appended with a single row insertion and the model is sorted
+ * afterwards if necessary.
+ */
+void TorrentsModelBase::addTorrents(const QVector<Torrent*> &torrents)
+{
+	if (torrents.size() <= MAX_SORT_MOVES) {
+		for (Torrent *torrent : torrents)
+			addTorrent(torrent);
+		return;
+	}
+	std::vector<Torrent*> sorted(torrents.begin(), torrents.end());
+	std::stable_sort(sorted.begin(), sorted.end(), [this](Torrent *t1, Torrent *t2) {
+		return compareTorrents(t1, t2) < 0;
+	});
+	// Append the torrents. An empty model is built in linear time.
+	const int first = mTorrents.size();
+	beginInsertRows(QModelIndex(), first, first + sorted.size() - 1);
+	if (first == 0) {
+		mTorrents.assign(sorted);
+	} else {
+		for (Torrent *torrent : sorted)
+			mTorrents.insert(mTorrents.size(), torrent);
+	}
+	lengthChanged();
+	endInsertRows();
+	// Sort the model unless all new torrents belong behind the old ones.
+	if (first > 0 && compareTorrents(mTorrents.at(first - 1), sorted.front()) > 0)
+		resortTorrents();
+}
+
 void TorrentsModelBase::removeTorrent(Torrent *torrent)
 {
 	// Check whether the torrent is part of the model. Do nothing if not.
-	auto it = mTorrentMap.find(torrent);
-	if (it != mTorrentMap.end()) {
-		// It is part of the model. We have to remove it.
-		// Get the row of the torrent.
-		const std::size_t i = it->second;
+	const int row = mTorrents.indexOf(torrent);
+	if (row >= 0) {
 		// Inform listeners that we will delete a torrent.
-		beginRemoveRows(QModelIndex(), i, i);
-		// Remove the torrent from the list and map.
-		mTorrentMap.erase(it);
-		mTorrentList.erase(mTorrentList.begin() + i);
-		// Update the map. Every torrent after the removed one has another row
-		// number now.
-		updateRowNumbers(i, -1);
+		beginRemoveRows(QModelIndex(), row, row);
+		// Remove the torrent from the list.
+		mTorrents.remove(torrent);
 		// Inform listeners that we have finished the process.
 		lengthChanged();
 		endRemoveRows();
 	}
 }
 
-void TorrentsModelBase::handleTorrentUpdate(Torrent *torrent, bool metadata)
+/**
+ * @brief Restores the order of the model after the given torrents changed.
+ *
+ * Only pairs of neighbors which contain an updated torrent can be out of order.
+ * A few torrents which are out of order are moved to their new rows. If there
+ * are many, the whole model is sorted within a single layout change.
+ *
+ * @param updated The torrents which have been updated.
+ */
+void TorrentsModelBase::sortTorrents(const QVector<Torrent*> &updated)
 {
-	const int lastRow = mTorrentList.length() - 1;
-	// Get the position of the torrent in the map.
-	const auto it = mTorrentMap.find(torrent);
-	// Maybe we have not added the torrent yet. Check if we should add it now.
-	if (it == mTorrentMap.end()) {
-		if (validateTorrent(torrent) == AcceptTorrent)
-			addTorrent(torrent);
-		return;
-	}
-	// Check whether we should keep the torrent in the model.
-	if (validateTorrent(torrent) == RemoveTorrent) {
-		removeTorrent(torrent);
-		return; // Nothing to do since the torrent was removed.
+	// Collect the torrents which are out of order.
+	QVector<Torrent*> unordered;
+	for (Torrent *t : updated) {
+		if (!isInOrder(t)) {
+			unordered.push_back(t);
+			if (unordered.size() > MAX_SORT_MOVES) {
+				resortTorrents();
+				return;
+			}
+		}
 	}
-	// Get the row of the torrent.
-	int row = it->second;
-	// Emit signal to propagate changes.
-	if (metadata)
-		dataChanged(index(row, 0), index(row, 0), {Qt::DisplayRole, Qt::ToolTipRole});
-	torrentUpdated(torrent);
-	// Search for new row position to keep the model sorted.
-	int newRow = row;
-	while (newRow > 0 && compareTorrents(mTorrentList[newRow - 1], torrent) > 0)
-		--newRow;
-	while (newRow < lastRow && compareTorrents(mTorrentList[newRow + 1], torrent) < 0)
-		++newRow;
-	// Move row if it is required.
-	if (newRow != row) {
-		// Inform listeners that we will move a torrent.
-		beginMoveRows(QModelIndex(), row, row, QModelIndex(), newRow);
-		// Move the torrent in the list.
-		mTorrentList.move(row, newRow);
-		// Update the map. Every torrent between row and newRow has another row
-		// number now.
-		if (newRow < row)
-			updateRowNumbers(newRow, +1, row - 1);
-		else
-			updateRowNumbers(row + 1, -1, newRow);
-		it->second = newRow;
-		// Inform listeners that we have finished the process.
-		endMoveRows();
+	for (Torrent *t : unordered)
+		moveTorrent(t);
+	// A torrent may have been moved next to one which was still out of order.
+	// Sort everything in this case.
+	if (!unordered.isEmpty()
+			&& !std::all_of(updated.begin(), updated.end(),
+			                [this](Torrent *t) {return isInOrder(t);}))
+		resortTorrents();
+}
+
+//! Moves the torrent to its sorted row among the other torrents.
+void TorrentsModelBase::moveTorrent(Torrent *torrent)
+{
+	// Find the new row without the torrent and put it back until listeners
+	// are informed.
+	const int row = mTorrents.indexOf(torrent);
+	mTorrents.remove(torrent);
+	const int newRow = mTorrents.upperBound(torrent, [this](Torrent *t1, Torrent *t2) {
+		return compareTorrents(t1, t2) < 0;
+	});
+	mTorrents.insert(row, torrent);
+	if (newRow == row)
+		return;
+	// Move the torrent. The destination is the row before which it is
+	// inserted, counted before the move.
+	beginMoveRows(QModelIndex(), row, row,
+	              QModelIndex(), newRow > row ? newRow + 1 : newRow);
+	mTorrents.remove(torrent);
+	mTorrents.insert(newRow, torrent);
+	endMoveRows();
+}
+
+//! Sorts the whole model within a single layout change.
+void TorrentsModelBase::resortTorrents()
+{
+	// Inform listeners that we will sort the model.
+	layoutAboutToBeChanged(QList<QPersistentModelIndex>(),
+	                       QAbstractItemModel::VerticalSortHint);
+	// Remember the torrents of persistent indexes.
+	const QModelIndexList oldIndexes = persistentIndexList();
+	QVector<Torrent*> persistentTorrents;
+	persistentTorrents.reserve(oldIndexes.size());
+	for (const QModelIndex &index : oldIndexes)
+		persistentTorrents.push_back(mTorrents.at(index.row()));
+	// Sort the list.
+	std::vector<Torrent*> torrents = mTorrents.toVector();
+	std::stable_sort(torrents.begin(), torrents.end(),
+	                 [this](Torrent *t1, Torrent *t2) {
+		return compareTorrents(t1, t2) < 0;
+	});
+	mTorrents.assign(torrents);
+	// Move persistent indexes to the new rows.
+	QModelIndexList newIndexes;
+	newIndexes.reserve(oldIndexes.size());
+	for (int i = 0; i < oldIndexes.size(); ++i) {
+		const int row = mTorrents.indexOf(persistentTorrents[i]);
+		newIndexes.append(index(row, oldIndexes[i].column()));
 	}
+	changePersistentIndexList(oldIndexes, newIndexes);
+	// Inform listeners that we have finished the process.
+	layoutChanged(QList<QPersistentModelIndex>(),
+	              QAbstractItemModel::VerticalSortHint);
+}
+
+//! Returns whether the torrent is correctly sorted regarding its neighbors.
+bool TorrentsModelBase::isInOrder(Torrent *torrent) const
+{
+	const int row = rowFromTorrent(torrent);
+	assert(row >= 0);
+	if (row > 0 && compareTorrents(mTorrents.at(row - 1), torrent) > 0)
+		return false;
+	if (row < mTorrents.size() - 1 && compareTorrents(torrent, mTorrents.at(row + 1)) > 0)
+		return false;
+	return true;
 }
 
 void TorrentsModelBase::registerHandler(Torrent *torrent)
 {
 	connect(torrent, &Torrent::metadataReceived,
 	        this, &TorrentsModelBase::onTorrentMetadataUpdated);
-	connect(torrent, &Torrent::statusUpdated,
-	        this, &TorrentsModelBase::onTorrentStatusUpdated);
 }
 
 void TorrentsModelBase::unregisterHandler(Torrent *torrent)
 {
 	disconnect(torrent, &Torrent::metadataReceived,
-	           this, &TorrentsModelBase::onTorrentStatusUpdated);
-	disconnect(torrent, &Torrent::metadataReceived,
-	           this, &TorrentsModelBase::onTorrentStatusUpdated);
-}
-
-void TorrentsModelBase::updateRowNumbers(int firstRow, int addition, int lastRow)
-{
-	lastRow = lastRow < 0 ? length() : lastRow;
-	for (auto &entry : mTorrentMap) {
-		if (entry.second >= firstRow && entry.second <= lastRow) {
-			entry.second += addition;
-		}
-	}
+	           this, &TorrentsModelBase::onTorrentMetadataUpdated);
 }
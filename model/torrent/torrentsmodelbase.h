@@ -1,11 +1,13 @@
 #ifndef TORRENTSMODELBASE_H
 #define TORRENTSMODELBASE_H
 
-#include <map>
+#include <unordered_set>
 
 #include <Qt>
 #include <QAbstractListModel>
-#include <QList>
+#include <QVector>
+
+#include "indexedlist.h"
 
 class Torrent;
 
@@ -24,9 +26,8 @@ public:
 
 	int rowFromTorrent(const Torrent *torrent) const;
 	Torrent *torrentFromRow(int row) const;
-	//const QVector<Torrent*> &asVector() const {return mTorrentList;}
 
-	int length() const {return mTorrentList.length();}
+	int length() const {return mTorrents.size();}
 
 	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 	QVariant data(const QModelIndex &index, int role) const override;
@@ -34,7 +35,9 @@ public:
 
 signals:
 	void lengthChanged();
-	void torrentUpdated(Torrent *torrent);
+	//! Emitted once per status update for all torrents of the model which
+	//! were updated.
+	void torrentsUpdated(const QVector<Torrent*> &torrents);
 
 protected:
 	enum ValidationResult {
@@ -48,22 +51,26 @@ protected:
 
 protected slots:
 	void trackTorrent(Torrent *torrent);
+	void trackTorrents(const QVector<Torrent*> &torrents);
 	void untrackTorrent(Torrent *torrent);
+	void updateTorrents(const QVector<Torrent*> &torrents);
 
 private slots:
 	void onTorrentMetadataUpdated();
-	void onTorrentStatusUpdated();
 
 private:
 	void addTorrent(Torrent *torrent);
+	void addTorrents(const QVector<Torrent*> &torrents);
 	void removeTorrent(Torrent *torrent);
-	void handleTorrentUpdate(Torrent *torrent, bool metadata);
+	void sortTorrents(const QVector<Torrent*> &updated);
+	void moveTorrent(Torrent *torrent);
+	void resortTorrents();
+	bool isInOrder(Torrent *torrent) const;
 	void registerHandler(Torrent *torrent);
 	void unregisterHandler(Torrent *torrent);
-	void updateRowNumbers(int firstRow, int addition, int lastRow = -1);
 
-	QList<Torrent*> mTorrentList;
-	std::map<const Torrent*,int> mTorrentMap;
+	IndexedList<Torrent*> mTorrents;
+	std::unordered_set<const Torrent*> mTrackedTorrents;
 
 };
 
@@ -1,174 +1,125 @@
 #include "torrentstatus.h"
 
 #include <cassert>
+#include <string>
 
 #include <libtorrent/torrent_handle.hpp>
 
 namespace lt = libtorrent;
 static TorrentStatus::State stateFromLibtorrent(lt::torrent_status::state_t state);
+static const QString &decode(const std::string &raw, QString &decoded);
 
 
-TorrentStatus::TorrentStatus(QObject *parent) :
-	QObject(parent),
+TorrentStatus::TorrentStatus() :
+	mAddedTime(0),
+	mCompletedTime(0),
 	mState(ADDING),
 	mProgressPPM(0),
 	mDownloadRate(0),
 	mDownloadPayloadRate(0),
 	mUploadRate(0),
-	mUploadPayloadRate(0)
+	mUploadPayloadRate(0),
+	mPeers(0),
+	mSeeds(0),
+	mUploads(0),
+	mQueuePosition(-1)
 {
 }
 
-TorrentStatus::~TorrentStatus()
+const QString &TorrentStatus::name() const
 {
+	return decode(mRawName, mName);
 }
 
-void TorrentStatus::setName(const QString &name)
+const QString &TorrentStatus::savePath() const
 {
-	if (mName != name) {
-		mName = name;
-		nameChanged();
-	}
-}
-
-void TorrentStatus::setSavePath(const QString &savePath)
-{
-	if (mSavePath != savePath) {
-		mSavePath = savePath;
-		savePathChanged();
-	}
+	return decode(mRawSavePath, mSavePath);
 }
 
-void TorrentStatus::setError(const QString &error)
+const QString &TorrentStatus::error() const
 {
-	if (mError != error) {
-		mError = error;
-		errorChanged();
-	}
+	return decode(mRawError, mError);
 }
 
-void TorrentStatus::setState(TorrentStatus::State state)
+const QString &TorrentStatus::currentTracker() const
 {
-	if (mState != state) {
-		mState = state;
-		stateChanged();
-	}
+	return decode(mRawCurrentTracker, mCurrentTracker);
 }
 
-void TorrentStatus::setProgressPPM(int progressPPM)
+QDateTime TorrentStatus::addedTime() const
 {
-	if (mProgressPPM != progressPPM) {
-		mProgressPPM = progressPPM;
-		progressPPMChanged();
-	}
+	return QDateTime::fromTime_t(mAddedTime);
 }
 
-void TorrentStatus::setAddedTime(const QDateTime &addedTime)
+QDateTime TorrentStatus::completedTime() const
 {
-	if (mAddedTime != addedTime) {
-		mAddedTime = addedTime;
-		addedTimeChanged();
-	}
+	return QDateTime::fromTime_t(mCompletedTime);
 }
 
-void TorrentStatus::setCompletedTime(const QDateTime &completedTime)
+// Assigns the value and marks the field as changed if it differs.
+template<class T>
+static inline void assign(T &member, const T &value, TorrentStatus::Field field,
+			TorrentStatus::Fields &changed)
 {
-	if (mCompletedTime != completedTime) {
-		mCompletedTime = completedTime;
-		completedTimeChanged();
+	if (member != value) {
+		member = value;
+		changed |= field;
 	}
 }
 
-void TorrentStatus::setDownloadRate(int downloadRate)
+// Drops the decoded string if the raw value differs.
+static inline void assign(QString &decoded, std::string &raw,
+			const std::string &value, TorrentStatus::Field field,
+			TorrentStatus::Fields &changed)
 {
-	if (mDownloadRate != downloadRate) {
-		mDownloadRate = downloadRate;
-		downloadRateChanged();
+	if (raw != value) {
+		raw = value;
+		decoded = QString();
+		changed |= field;
 	}
 }
 
-void TorrentStatus::setDownloadPayloadRate(int downloadPayloadRate)
+/**
+ * @brief Loads the status from libtorrent.
+ *
+ * Strings are not decoded here and no QDateTime objects are created.
+ *
+ * @param status The status of libtorrent.
+ * @return The fields which have changed.
+ */
+TorrentStatus::Fields TorrentStatus::loadFromLibtorrent(const lt::torrent_status &status)
 {
-	if (mDownloadPayloadRate != downloadPayloadRate) {
-		mDownloadPayloadRate = downloadPayloadRate;
-		downloadPayloadRateChanged();
-	}
+	Fields changed;
+	assign(mName, mRawName, status.name, NameField, changed);
+	assign(mSavePath, mRawSavePath, status.save_path, SavePathField, changed);
+	assign(mError, mRawError, status.error, ErrorField, changed);
+	assign(mState, stateFromLibtorrent(status.state), StateField, changed);
+	assign(mProgressPPM, status.progress_ppm, ProgressPPMField, changed);
+	assign(mAddedTime, (std::int64_t) status.added_time, AddedTimeField, changed);
+	assign(mCompletedTime, (std::int64_t) status.completed_time, CompletedTimeField, changed);
+	assign(mDownloadRate, status.download_rate, DownloadRateField, changed);
+	assign(mDownloadPayloadRate, status.download_payload_rate, DownloadPayloadRateField, changed);
+	assign(mUploadRate, status.upload_rate, UploadRateField, changed);
+	assign(mUploadPayloadRate, status.upload_payload_rate, UploadPayloadRateField, changed);
+	assign(mPeers, status.num_peers, PeersField, changed);
+	assign(mSeeds, status.num_seeds, SeedsField, changed);
+	assign(mUploads, status.num_uploads, UploadsField, changed);
+	assign(mQueuePosition, status.queue_position, QueuePositionField, changed);
+	assign(mCurrentTracker, mRawCurrentTracker, status.current_tracker, CurrentTrackerField, changed);
+	mChangedFields = changed;
+	return changed;
 }
 
-void TorrentStatus::setUploadRate(int uploadRate)
+// Decodes the UTF-8 string unless it has been decoded already. Empty strings
+// are decoded to an empty but not null string, so they are not decoded again.
+static const QString &decode(const std::string &raw, QString &decoded)
 {
-	if (mUploadRate != uploadRate) {
-		mUploadRate = uploadRate;
-		uploadRateChanged();
+	if (decoded.isNull()) {
+		decoded = QString::fromUtf8(raw.data(), raw.size());
+		if (decoded.isNull())
+			decoded = QStringLiteral("");
 	}
-}
-
-void TorrentStatus::setUploadPayloadRate(int uploadPayloadRate)
-{
-	if (mUploadPayloadRate != uploadPayloadRate) {
-		mUploadPayloadRate = uploadPayloadRate;
-		uploadPayloadRateChanged();
-	}
-}
-
-void TorrentStatus::setPeers(int peers)
-{
-	if (mPeers != peers) {
-		mPeers = peers;
-		peersChanged();
-	}
-}
-
-void TorrentStatus::setSeeds(int seeds)
-{
-	if (mSeeds != seeds) {
-		mSeeds = seeds;
-		seedsChanged();
-	}
-}
-
-void TorrentStatus::setUploads(int uploads)
-{
-	if (mUploads != uploads) {
-		mUploads = uploads;
-		uploadsChanged();
-	}
-}
-
-void TorrentStatus::setQueuePosition(int queuePosition)
-{
-	if (mQueuePosition != queuePosition) {
-		mQueuePosition = queuePosition;
-		queuePositionChanged();
-	}
-}
-
-void TorrentStatus::setCurrentTracker(const QString &currentTracker)
-{
-	if (mCurrentTracker != currentTracker) {
-		mCurrentTracker = currentTracker;
-		currentTrackerChanged();
-	}
-}
-
-void TorrentStatus::loadFromLibtorrent(const lt::torrent_status &status)
-{
-	setName(QString::fromStdString(status.name));
-	setSavePath(QString::fromStdString(status.save_path));
-	setError(QString::fromStdString(status.error));
-	setState(stateFromLibtorrent(status.state));
-	setProgressPPM(status.progress_ppm);
-	setAddedTime(QDateTime::fromTime_t(status.added_time));
-	setCompletedTime(QDateTime::fromTime_t(status.completed_time));
-	setDownloadRate(status.download_rate);
-	setDownloadPayloadRate(status.download_payload_rate);
-	setUploadRate(status.upload_rate);
-	setUploadPayloadRate(status.upload_payload_rate);
-	setPeers(status.num_peers);
-	setSeeds(status.num_seeds);
-	setUploads(status.num_uploads);
-	setQueuePosition(status.queue_position);
-	setCurrentTracker(QString::fromStdString(status.current_tracker));
+	return decoded;
 }
 
 TorrentStatus::State stateFromLibtorrent(lt::torrent_status::state_t state)
@@ -1,7 +1,11 @@
 #ifndef TORRENTSTATUS_H
 #define TORRENTSTATUS_H
 
+#include <cstdint>
+#include <string>
+
 #include <QDateTime>
+#include <QFlags>
 #include <QObject>
 #include <QString>
 
@@ -10,41 +14,18 @@ struct torrent_status;
 }
 
 
-class TorrentStatus : public QObject
+/**
+ * @brief Snapshot of the status of a torrent.
+ *
+ * This is a plain value type. TorrentStatus::loadFromLibtorrent returns which
+ * fields have changed. Strings are kept as libtorrent delivers them and only
+ * decoded when they are first accessed after a change, like in TorrentInfo.
+ * Use TorrentStatusObject if you need a QObject with properties and change
+ * signals.
+ */
+class TorrentStatus
 {
-	Q_OBJECT
-	Q_PROPERTY(QString   name                READ name
-	           WRITE  setName                NOTIFY nameChanged)
-	Q_PROPERTY(QString   savePath            READ savePath
-	           WRITE  setSavePath            NOTIFY savePathChanged)
-	Q_PROPERTY(QString   error               READ error
-	           WRITE  setError               NOTIFY errorChanged)
-	Q_PROPERTY(State     state               READ state
-	           WRITE  setState               NOTIFY stateChanged)
-	Q_PROPERTY(int       progressPPM         READ progressPPM
-	           WRITE  setProgressPPM         NOTIFY progressPPMChanged)
-	Q_PROPERTY(QDateTime addedTime           READ addedTime
-	           WRITE  setAddedTime           NOTIFY addedTimeChanged)
-	Q_PROPERTY(QDateTime completedTime       READ completedTime
-	           WRITE  setCompletedTime       NOTIFY completedTimeChanged)
-	Q_PROPERTY(int       downloadRate        READ downloadRate
-	           WRITE  setDownloadRate        NOTIFY downloadRateChanged)
-	Q_PROPERTY(int       downloadPayloadRate READ downloadPayloadRate
-	           WRITE  setDownloadPayloadRate NOTIFY downloadPayloadRateChanged)
-	Q_PROPERTY(int       uploadRate          READ uploadRate
-	           WRITE  setUploadRate          NOTIFY uploadRateChanged)
-	Q_PROPERTY(int       uploadPayloadRate   READ uploadPayloadRate
-	           WRITE  setUploadPayloadRate   NOTIFY uploadPayloadRateChanged)
-	Q_PROPERTY(int       peers               READ peers
-	           WRITE  setPeers               NOTIFY peersChanged)
-	Q_PROPERTY(int       seeds               READ seeds
-	           WRITE  setSeeds               NOTIFY seedsChanged)
-	Q_PROPERTY(int       uploads             READ uploads
-	           WRITE setUploads              NOTIFY uploadsChanged)
-	Q_PROPERTY(int       queuePosition       READ queuePosition
-	           WRITE setQueuePosition        NOTIFY queuePositionChanged)
-	Q_PROPERTY(QString   currentTracker      READ currentTracker
-	           WRITE  setCurrentTracker      NOTIFY currentTrackerChanged)
+	Q_GADGET
 
 public:
 	enum State {
@@ -59,16 +40,37 @@ public:
 		CHECKING_RESUME_DATA
 	}; Q_ENUM(State)
 
-	explicit TorrentStatus(QObject *parent = 0);
-	virtual ~TorrentStatus();
+	enum Field {
+		NameField                = 1 << 0,
+		SavePathField            = 1 << 1,
+		ErrorField               = 1 << 2,
+		StateField               = 1 << 3,
+		ProgressPPMField         = 1 << 4,
+		AddedTimeField           = 1 << 5,
+		CompletedTimeField       = 1 << 6,
+		DownloadRateField        = 1 << 7,
+		DownloadPayloadRateField = 1 << 8,
+		UploadRateField          = 1 << 9,
+		UploadPayloadRateField   = 1 << 10,
+		PeersField               = 1 << 11,
+		SeedsField               = 1 << 12,
+		UploadsField             = 1 << 13,
+		QueuePositionField       = 1 << 14,
+		CurrentTrackerField      = 1 << 15,
+		AllFields                = (1 << 16) - 1
+	};
+	Q_DECLARE_FLAGS(Fields, Field)
+	Q_FLAG(Fields)
+
+	TorrentStatus();
 
-	const QString &name() const {return mName;}
-	const QString &savePath() const {return mSavePath;}
-	const QString &error() const {return mError;}
+	const QString &name() const;
+	const QString &savePath() const;
+	const QString &error() const;
 	State state() const {return mState;}
 	int progressPPM() const {return mProgressPPM;}
-	const QDateTime &addedTime() const {return mAddedTime;}
-	const QDateTime &completedTime() const {return mCompletedTime;}
+	QDateTime addedTime() const;
+	QDateTime completedTime() const;
 	int downloadRate() const {return mDownloadRate;}
 	int downloadPayloadRate() const {return mDownloadPayloadRate;}
 	int uploadRate() const {return mUploadRate;}
@@ -77,53 +79,28 @@ public:
 	int seeds() const {return mSeeds;}
 	int uploads() const {return mUploads;}
 	int queuePosition() const {return mQueuePosition;}
-	const QString &currentTracker() const {return mCurrentTracker;}
+	const QString &currentTracker() const;
 
-	void setName(const QString &name);
-	void setSavePath(const QString &savePath);
-	void setError(const QString &error);
-	void setState(State state);
-	void setProgressPPM(int progressPPM);
-	void setAddedTime(const QDateTime &addedTime);
-	void setCompletedTime(const QDateTime &completedTime);
-	void setDownloadRate(int downloadRate);
-	void setDownloadPayloadRate(int downloadPayloadRate);
-	void setUploadRate(int uploadRate);
-	void setUploadPayloadRate(int uploadPayloadRate);
-	void setPeers(int peers);
-	void setSeeds(int seeds);
-	void setUploads(int uploads);
-	void setQueuePosition(int queuePosition);
-	void setCurrentTracker(const QString &currentTracker);
+	//! Fields which changed with the last call of loadFromLibtorrent.
+	Fields changedFields() const {return mChangedFields;}
 
-	void loadFromLibtorrent(const libtorrent::torrent_status &status);
-
-signals:
-	void nameChanged();
-	void savePathChanged();
-	void errorChanged();
-	void stateChanged();
-	void progressPPMChanged();
-	void addedTimeChanged();
-	void completedTimeChanged();
-	void downloadRateChanged();
-	void downloadPayloadRateChanged();
-	void uploadRateChanged();
-	void uploadPayloadRateChanged();
-	void peersChanged();
-	void seedsChanged();
-	void uploadsChanged();
-	void queuePositionChanged();
-	void currentTrackerChanged();
+	Fields loadFromLibtorrent(const libtorrent::torrent_status &status);
 
 private:
-	QString mName;
-	QString mSavePath;
-	QString mError;
+	// Raw strings of libtorrent.
+	std::string mRawName;
+	std::string mRawSavePath;
+	std::string mRawError;
+	std::string mRawCurrentTracker;
+	// Decoded on first access, null while not decoded.
+	mutable QString mName;
+	mutable QString mSavePath;
+	mutable QString mError;
+	mutable QString mCurrentTracker;
+	std::int64_t mAddedTime;
+	std::int64_t mCompletedTime;
 	State mState;
 	int mProgressPPM;
-	QDateTime mAddedTime;
-	QDateTime mCompletedTime;
 	int mDownloadRate;
 	int mDownloadPayloadRate;
 	int mUploadRate;
@@ -132,8 +109,10 @@ private:
 	int mSeeds;
 	int mUploads;
 	int mQueuePosition;
-	QString mCurrentTracker;
+	Fields mChangedFields;
 
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(TorrentStatus::Fields)
+
 #endif // TORRENTSTATUS_H
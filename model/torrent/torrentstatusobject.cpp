@@ -0,0 +1,32 @@
+#include "torrentstatusobject.h"
+
+
+TorrentStatusObject::TorrentStatusObject(const TorrentStatus *status, QObject *parent) :
+	QObject(parent),
+	mStatus(status)
+{
+}
+
+/**
+ * @brief Emits the change signals of the given fields.
+ * @param changed The fields which have changed.
+ */
+void TorrentStatusObject::notify(TorrentStatus::Fields changed)
+{
+	if (changed & TorrentStatus::NameField) emit nameChanged();
+	if (changed & TorrentStatus::SavePathField) emit savePathChanged();
+	if (changed & TorrentStatus::ErrorField) emit errorChanged();
+	if (changed & TorrentStatus::StateField) emit stateChanged();
+	if (changed & TorrentStatus::ProgressPPMField) emit progressPPMChanged();
+	if (changed & TorrentStatus::AddedTimeField) emit addedTimeChanged();
+	if (changed & TorrentStatus::CompletedTimeField) emit completedTimeChanged();
+	if (changed & TorrentStatus::DownloadRateField) emit downloadRateChanged();
+	if (changed & TorrentStatus::DownloadPayloadRateField) emit downloadPayloadRateChanged();
+	if (changed & TorrentStatus::UploadRateField) emit uploadRateChanged();
+	if (changed & TorrentStatus::UploadPayloadRateField) emit uploadPayloadRateChanged();
+	if (changed & TorrentStatus::PeersField) emit peersChanged();
+	if (changed & TorrentStatus::SeedsField) emit seedsChanged();
+	if (changed & TorrentStatus::UploadsField) emit uploadsChanged();
+	if (changed & TorrentStatus::QueuePositionField) emit queuePositionChanged();
+	if (changed & TorrentStatus::CurrentTrackerField) emit currentTrackerChanged();
+}
@@ -0,0 +1,82 @@
+#ifndef TORRENTSTATUSOBJECT_H
+#define TORRENTSTATUSOBJECT_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+
+#include "torrentstatus.h"
+
+
+/**
+ * @brief Read-only QObject view of a TorrentStatus.
+ *
+ * Provides properties with change signals for bindings. The signals are only
+ * emitted for the fields passed to TorrentStatusObject::notify.
+ */
+class TorrentStatusObject : public QObject
+{
+	Q_OBJECT
+	Q_PROPERTY(QString   name                READ name                NOTIFY nameChanged)
+	Q_PROPERTY(QString   savePath            READ savePath            NOTIFY savePathChanged)
+	Q_PROPERTY(QString   error               READ error               NOTIFY errorChanged)
+	Q_PROPERTY(TorrentStatus::State state    READ state               NOTIFY stateChanged)
+	Q_PROPERTY(int       progressPPM         READ progressPPM         NOTIFY progressPPMChanged)
+	Q_PROPERTY(QDateTime addedTime           READ addedTime           NOTIFY addedTimeChanged)
+	Q_PROPERTY(QDateTime completedTime       READ completedTime       NOTIFY completedTimeChanged)
+	Q_PROPERTY(int       downloadRate        READ downloadRate        NOTIFY downloadRateChanged)
+	Q_PROPERTY(int       downloadPayloadRate READ downloadPayloadRate NOTIFY downloadPayloadRateChanged)
+	Q_PROPERTY(int       uploadRate          READ uploadRate          NOTIFY uploadRateChanged)
+	Q_PROPERTY(int       uploadPayloadRate   READ uploadPayloadRate   NOTIFY uploadPayloadRateChanged)
+	Q_PROPERTY(int       peers               READ peers               NOTIFY peersChanged)
+	Q_PROPERTY(int       seeds               READ seeds               NOTIFY seedsChanged)
+	Q_PROPERTY(int       uploads             READ uploads             NOTIFY uploadsChanged)
+	Q_PROPERTY(int       queuePosition       READ queuePosition       NOTIFY queuePositionChanged)
+	Q_PROPERTY(QString   currentTracker      READ currentTracker      NOTIFY currentTrackerChanged)
+
+public:
+	TorrentStatusObject(const TorrentStatus *status, QObject *parent = 0);
+
+	QString name() const {return mStatus->name();}
+	QString savePath() const {return mStatus->savePath();}
+	QString error() const {return mStatus->error();}
+	TorrentStatus::State state() const {return mStatus->state();}
+	int progressPPM() const {return mStatus->progressPPM();}
+	QDateTime addedTime() const {return mStatus->addedTime();}
+	QDateTime completedTime() const {return mStatus->completedTime();}
+	int downloadRate() const {return mStatus->downloadRate();}
+	int downloadPayloadRate() const {return mStatus->downloadPayloadRate();}
+	int uploadRate() const {return mStatus->uploadRate();}
+	int uploadPayloadRate() const {return mStatus->uploadPayloadRate();}
+	int peers() const {return mStatus->peers();}
+	int seeds() const {return mStatus->seeds();}
+	int uploads() const {return mStatus->uploads();}
+	int queuePosition() const {return mStatus->queuePosition();}
+	QString currentTracker() const {return mStatus->currentTracker();}
+
+	void notify(TorrentStatus::Fields changed);
+
+signals:
+	void nameChanged();
+	void savePathChanged();
+	void errorChanged();
+	void stateChanged();
+	void progressPPMChanged();
+	void addedTimeChanged();
+	void completedTimeChanged();
+	void downloadRateChanged();
+	void downloadPayloadRateChanged();
+	void uploadRateChanged();
+	void uploadPayloadRateChanged();
+	void peersChanged();
+	void seedsChanged();
+	void uploadsChanged();
+	void queuePositionChanged();
+	void currentTrackerChanged();
+
+private:
+	const TorrentStatus *mStatus;
+
+};
+
+#endif // TORRENTSTATUSOBJECT_H
@@ -0,0 +1,273 @@
+#include "torrentstreamer.h"
+
+#include <algorithm>
+
+#include <QTimer>
+
+#include <libtorrent/error_code.hpp>
+#include <libtorrent/torrent_info.hpp>
+
+namespace lt = libtorrent;
+
+// Interval in which the windows follow the downloaded pieces in ms.
+static const int UPDATE_INTERVAL = 500;
+// Amount of data behind the cursor which gets deadlines.
+static const int WINDOW_SIZE = 16 * 1024 * 1024;
+// Minimum number of pieces in the window.
+static const int MIN_WINDOW_PIECES = 4;
+// Deadline of the piece at the cursor and the increase per further piece in ms.
+static const int FIRST_DEADLINE = 500;
+static const int DEADLINE_STEP = 250;
+// Amount of data behind the cursor which is measured as the first bytes.
+static const int FIRST_BYTES = 16 * 1024 * 1024;
+// Distributed copies of the swarm above which pieces are requested
+// sequentially, and below which the rarest pieces are requested first again.
+static const float SEQUENTIAL_MIN_COPIES = 2.0f;
+static const float RAREST_FIRST_MAX_COPIES = 1.5f;
+
+
+TorrentStreamer::TorrentStreamer(QObject *parent) :
+	QObject(parent),
+	mTimer(new QTimer(this))
+{
+	connect(mTimer, &QTimer::timeout,
+	        this, &TorrentStreamer::updateStreams);
+}
+
+TorrentStreamer::~TorrentStreamer()
+{
+}
+
+/**
+ * @brief Starts or stops streaming a torrent.
+ *
+ * The read cursor of a new stream is at the first piece.
+ */
+void TorrentStreamer::setStreaming(const lt::torrent_handle &handle, bool enabled)
+{
+	const lt::sha1_hash infoHash = handle.info_hash();
+	const auto it = mStreams.find(infoHash);
+	if (!enabled) {
+		if (it != mStreams.end()) {
+			stop(it->second);
+			mStreams.erase(it);
+		}
+	} else if (it == mStreams.end()) {
+		Stream &stream = mStreams[infoHash];
+		stream.handle = handle;
+		stream.timer.start();
+		if (!update(stream))
+			mStreams.erase(infoHash);
+	}
+	updateTimer();
+}
+
+//! Moves the read cursor of a streamed torrent to the given piece.
+void TorrentStreamer::setReadCursor(const lt::torrent_handle &handle, int piece)
+{
+	const auto it = mStreams.find(handle.info_hash());
+	if (it == mStreams.end())
+		return;
+	Stream &stream = it->second;
+	stream.cursor = std::max(piece, 0);
+	// Measure the first bytes at the position the reader starts with.
+	if (!stream.firstBytesDone)
+		stream.firstPiece = stream.cursor;
+	if (!update(stream)) {
+		mStreams.erase(it);
+		updateTimer();
+	}
+}
+
+//! Records the throughput of a finished torrent and ends its stream.
+void TorrentStreamer::onFinished(const lt::torrent_handle &handle)
+{
+	lt::torrent_status status;
+	try {
+		status = handle.status();
+	} catch (const lt::libtorrent_exception &) {
+		return;
+	}
+	// The stream may have noticed already that it is finished.
+	if (mFinishedStreams.erase(status.info_hash))
+		return;
+	const auto it = mStreams.find(status.info_hash);
+	const bool streamed = it != mStreams.end();
+	if (streamed) {
+		stop(it->second);
+		mStreams.erase(it);
+		updateTimer();
+	}
+	recordFinished(status, streamed);
+}
+
+// Adds a finished torrent to the throughput of streamed or other torrents.
+void TorrentStreamer::recordFinished(const lt::torrent_status &status, bool streamed)
+{
+	// Torrents which were complete when they were added downloaded nothing.
+	if (status.total_payload_download <= 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	if (streamed) {
+		++mStats.streamedTorrents;
+		mStats.streamedBytes += status.total_payload_download;
+		mStats.streamedTime += status.active_time;
+	} else {
+		++mStats.downloadedTorrents;
+		mStats.downloadedBytes += status.total_payload_download;
+		mStats.downloadedTime += status.active_time;
+	}
+}
+
+void TorrentStreamer::onRemoved(const lt::sha1_hash &infoHash)
+{
+	mStreams.erase(infoHash);
+	mFinishedStreams.erase(infoHash);
+	updateTimer();
+}
+
+//! Ends all streams, e.g. before the session is destroyed.
+void TorrentStreamer::stopAll()
+{
+	for (auto &stream : mStreams) {
+		stop(stream.second);
+	}
+	mStreams.clear();
+	mFinishedStreams.clear();
+	mTimer->stop();
+}
+
+TorrentStreamer::Stats TorrentStreamer::stats() const
+{
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	return mStats;
+}
+
+void TorrentStreamer::updateStreams()
+{
+	for (auto it = mStreams.begin(); it != mStreams.end();) {
+		if (update(it->second))
+			++it;
+		else
+			it = mStreams.erase(it);
+	}
+	updateTimer();
+}
+
+// Runs the timer as long as there are streams.
+void TorrentStreamer::updateTimer()
+{
+	if (mStreams.empty())
+		mTimer->stop();
+	else if (!mTimer->isActive())
+		mTimer->start(UPDATE_INTERVAL);
+}
+
+// Follows the downloaded pieces of a stream. Returns false if the stream has
+// ended because the torrent is finished or gone.
+bool TorrentStreamer::update(Stream &stream)
+{
+	lt::torrent_status status;
+	boost::intrusive_ptr<const lt::torrent_info> info;
+	try {
+		// The availability decides between sequential and rarest first.
+		status = stream.handle.status(lt::torrent_handle::query_pieces
+		                              | lt::torrent_handle::query_distributed_copies);
+		if (status.is_finished) {
+			stop(stream);
+			// Record the stream before torrent_finished_alert arrives.
+			// Torrents which were finished before streaming are not counted.
+			if (stream.started) {
+				if (!stream.firstBytesDone)
+					recordFirstBytes(stream);
+				recordFinished(status, true);
+				mFinishedStreams.insert(status.info_hash);
+			}
+			return false;
+		}
+		stream.started = true;
+		info = stream.handle.torrent_file();
+		// Magnet links have no pieces until the metadata arrives.
+		if (!info || status.pieces.size() == 0)
+			return true;
+		updateWindow(stream, status, *info);
+	} catch (const lt::libtorrent_exception &) {
+		// The torrent has been removed in the meantime.
+		return false;
+	}
+
+	// Measure how long the first bytes behind the cursor took.
+	if (!stream.firstBytesDone) {
+		const int firstPieces = std::max(FIRST_BYTES / info->piece_length(), 1);
+		const int end = std::min(stream.firstPiece + firstPieces, status.pieces.size());
+		bool complete = true;
+		for (int piece = stream.firstPiece; piece < end && complete; ++piece) {
+			complete = status.pieces[piece];
+		}
+		if (complete)
+			recordFirstBytes(stream);
+	}
+	return true;
+}
+
+// Records the time until the first bytes behind the cursor arrived.
+void TorrentStreamer::recordFirstBytes(Stream &stream)
+{
+	stream.firstBytesDone = true;
+	std::lock_guard<std::mutex> lock(mStatsMutex);
+	++mStats.firstBytesStreams;
+	mStats.firstBytesTimeSum += stream.timer.elapsed();
+}
+
+// Moves the window of deadlines to the missing pieces behind the cursor and
+// chooses the order of the other pieces.
+void TorrentStreamer::updateWindow(Stream &stream, const lt::torrent_status &status,
+			const lt::torrent_info &info)
+{
+	const int numPieces = status.pieces.size();
+	const int cursor = std::min(stream.cursor, numPieces - 1);
+	const int windowPieces = std::max(WINDOW_SIZE / info.piece_length(), MIN_WINDOW_PIECES);
+
+	// Give the next missing pieces deadlines and drop the old ones.
+	std::set<int> window;
+	for (int piece = cursor; piece < numPieces && (int) window.size() < windowPieces; ++piece) {
+		if (!status.pieces[piece])
+			window.insert(piece);
+	}
+	for (int piece : stream.deadlines) {
+		if (!window.count(piece) && !status.pieces[piece])
+			stream.handle.reset_piece_deadline(piece);
+	}
+	int deadline = FIRST_DEADLINE;
+	for (int piece : window) {
+		if (!stream.deadlines.count(piece))
+			stream.handle.set_piece_deadline(piece, deadline);
+		deadline += DEADLINE_STEP;
+	}
+	stream.deadlines.swap(window);
+
+	// Downloading sequentially is fine if the swarm has enough copies of
+	// every piece.
+	const float copies = status.distributed_copies;
+	const bool sequential = stream.sequential ? copies >= RAREST_FIRST_MAX_COPIES
+	                                          : copies >= SEQUENTIAL_MIN_COPIES;
+	if (sequential != stream.sequential) {
+		stream.sequential = sequential;
+		stream.handle.set_sequential_download(sequential);
+	}
+}
+
+// Returns the torrent to the normal order of pieces.
+void TorrentStreamer::stop(Stream &stream)
+{
+	try {
+		for (int piece : stream.deadlines) {
+			stream.handle.reset_piece_deadline(piece);
+		}
+		if (stream.sequential)
+			stream.handle.set_sequential_download(false);
+	} catch (const lt::libtorrent_exception &) {
+		// The torrent has been removed in the meantime.
+	}
+}
@@ -0,0 +1,107 @@
+#ifndef TORRENTSTREAMER_H
+#define TORRENTSTREAMER_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <libtorrent/peer_id.hpp>
+#include <libtorrent/torrent_handle.hpp>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+namespace libtorrent {
+class torrent_info;
+}
+
+
+/**
+ * @brief Downloads torrents in the order they are read.
+ *
+ * Streamed torrents have a read cursor. The pieces behind it are downloaded
+ * first: a window of missing pieces starting at the cursor gets deadlines
+ * which grow with the distance to the cursor. The window slides forward as
+ * pieces arrive or the cursor moves.
+ *
+ * The remaining pieces are requested sequentially if every piece is
+ * available often enough in the swarm. Otherwise libtorrent keeps picking the
+ * rarest pieces first, so the streaming peer does not starve the swarm.
+ *
+ * Lives in the thread of the TorrentEngine. Only TorrentStreamer::stats may be
+ * called from another thread.
+ */
+class TorrentStreamer : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! Counters to compare streamed and normal downloads.
+	struct Stats {
+		//! Number of streams which have downloaded their first bytes.
+		std::uint64_t firstBytesStreams = 0;
+		//! Sum of the time until the first bytes behind the cursor arrived in ms.
+		std::uint64_t firstBytesTimeSum = 0;
+		//! Number, payload and active time in s of finished streamed torrents.
+		std::uint64_t streamedTorrents = 0;
+		std::uint64_t streamedBytes = 0;
+		std::uint64_t streamedTime = 0;
+		//! Number, payload and active time in s of other finished torrents.
+		std::uint64_t downloadedTorrents = 0;
+		std::uint64_t downloadedBytes = 0;
+		std::uint64_t downloadedTime = 0;
+	};
+
+	explicit TorrentStreamer(QObject *parent = 0);
+	virtual ~TorrentStreamer();
+
+	void setStreaming(const libtorrent::torrent_handle &handle, bool enabled);
+	void setReadCursor(const libtorrent::torrent_handle &handle, int piece);
+	void onFinished(const libtorrent::torrent_handle &handle);
+	void onRemoved(const libtorrent::sha1_hash &infoHash);
+	void stopAll();
+
+	Stats stats() const;
+
+private slots:
+	void updateStreams();
+
+private:
+	struct Stream {
+		libtorrent::torrent_handle handle;
+		int cursor = 0;
+		bool sequential = false;
+		// Pieces which have a deadline.
+		std::set<int> deadlines;
+		// Measures the time until the first bytes behind the cursor arrived.
+		QElapsedTimer timer;
+		int firstPiece = 0;
+		bool firstBytesDone = false;
+		// Whether the torrent was unfinished at the first update.
+		bool started = false;
+	};
+
+	bool update(Stream &stream);
+	void updateTimer();
+	void updateWindow(Stream &stream, const libtorrent::torrent_status &status,
+	                  const libtorrent::torrent_info &info);
+	void stop(Stream &stream);
+	void recordFirstBytes(Stream &stream);
+	void recordFinished(const libtorrent::torrent_status &status, bool streamed);
+
+	QTimer *mTimer;
+	std::map<libtorrent::sha1_hash, Stream> mStreams;
+	// Streams which have been recorded as finished before their
+	// torrent_finished_alert arrived.
+	std::set<libtorrent::sha1_hash> mFinishedStreams;
+
+	mutable std::mutex mStatsMutex;
+	Stats mStats;
+
+};
+
+#endif // TORRENTSTREAMER_H